@@ -1,15 +1,33 @@
 #include "archive.h"
 
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QProcess>
 #include <QFileInfo>
 #include <QDir>
 #include <QTime>
 #include <QCoreApplication>
 #include <QRegExp>
+#include <QTemporaryFile>
 
 #include <stdlib.h>
 
 #include "debug.h"
+#include "fileclassification.h"
+
+const Archive::Extension Archive::EXTENSIONS[] =
+{
+    {".tar", Tar},
+    {".zip", Zip},
+    {".cbz", Zip},
+    {".rar", Rar},
+    {".cbr", Rar},
+    {".7z", SevenZip},
+    // Ace
+    {".lzh", SevenZip},
+    {".ykp", Pack},
+    {"", InvalidArchiveType},
+};
 
 Archive::Archive(QObject *parent)
     : QObject(parent)
@@ -83,7 +101,7 @@ Archive::Archive(QObject *parent)
 void Archive::testPrograms()
 {
     // Start a process for each program
-    QProcess programs[InvalidArchiveType];
+    QProcess programs[NUM_PROGRAMS];
 
     programs[SevenZip].start(_programPaths[SevenZip], QStringList());
     programs[Tar].start(_programPaths[Tar], QStringList()<<"--version");
@@ -91,7 +109,7 @@ void Archive::testPrograms()
     programs[Rar].start(_programPaths[Rar], QStringList());
 
     // Wait for each process to finish
-    for (int i = 0; i < InvalidArchiveType; i++)
+    for (int i = 0; i < NUM_PROGRAMS; i++)
     {
         const int MAX_WAIT = 500;
         bool waited;
@@ -186,43 +204,79 @@ Archive::~Archive()
 {
 }
 
-void Archive::reset(const QString &filename)
+/**
+ * Returns false if the file can't be read (its type is then
+ * InvalidArchiveType).
+ */
+bool Archive::reset(const QString &filename)
 {
-    const struct
+    _filename = filename;
+    _type = InvalidArchiveType;
+    _startPageName.clear();
+    _pack.close();
+
+    // A loose image opens its folder, at that image
+    QFileInfo info(_filename);
+
+    if (!info.isDir() && FileClassification::isImageFile(QFile::encodeName(info.fileName())))
+    {
+        _startPageName = QFile::encodeName(info.fileName());
+        _filename = info.absolutePath();
+        info = QFileInfo(_filename);
+    }
+
+    // Identify the file by where it is and its size and modification time, so
+    // a changed archive isn't mistaken for the old one (a folder's own time
+    // doesn't change when an image is replaced in place, so it's identified
+    // again by its images once they're listed)
+    QCryptographicHash identity(QCryptographicHash::Sha1);
+    identity.addData(info.absoluteFilePath().toUtf8());
+    identity.addData(QByteArray::number(info.size()));
+    identity.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    _identity = identity.result().toHex();
+
+    // Folders and packs are read directly
+    if (info.isDir())
     {
-        const char *ext;
-        Type type;
+        _type = Directory;
     }
-    ARCHIVE_TYPES[] =
+    else
     {
-        {".tar", Tar},
-        {".zip", Zip},
-        {".cbz", Zip},
-        {".rar", Rar},
-        {".cbr", Rar},
-        {".7z", SevenZip},
-        // Ace
-        {".lzh", SevenZip},
-        {"", InvalidArchiveType},
-    };
+        _type = typeOf(_filename);
 
-    _filename = filename;
-    _type = InvalidArchiveType;
+        if (_type == Pack && !_pack.open(_filename))
+        {
+            _type = InvalidArchiveType;
+        }
+    }
 
-    for (int i = 0; *ARCHIVE_TYPES[i].ext != '\0'; i++)
+    debug()<<"Archive type"<<_type;
+    return _type != InvalidArchiveType;
+}
+
+/**
+ * The type an archive file would be read as, by its extension and the
+ * programs there are to read it (so an archive that can't be read is
+ * InvalidArchiveType).
+ */
+Archive::Type Archive::typeOf(const QString &filename) const
+{
+    Type type = InvalidArchiveType;
+
+    for (int i = 0; *EXTENSIONS[i].ext != '\0'; i++)
     {
-        if (_filename.endsWith(ARCHIVE_TYPES[i].ext, Qt::CaseInsensitive))
+        if (filename.endsWith(EXTENSIONS[i].ext, Qt::CaseInsensitive))
         {
-            _type = ARCHIVE_TYPES[i].type;
+            type = EXTENSIONS[i].type;
         }
     }
 
-    switch (_type)
+    switch (type)
     {
     case SevenZip:
         if (!_programExists[SevenZip])
         {
-            _type = InvalidArchiveType;
+            type = InvalidArchiveType;
         }
         break;
     case Tar:
@@ -230,11 +284,11 @@ void Archive::reset(const QString &filename)
         {
             if (!_programExists[SevenZip])
             {
-                _type = InvalidArchiveType;
+                type = InvalidArchiveType;
             }
             else
             {
-                _type = SevenZip;
+                type = SevenZip;
             }
         }
         break;
@@ -243,11 +297,11 @@ void Archive::reset(const QString &filename)
         {
             if (!_programExists[SevenZip])
             {
-                _type = InvalidArchiveType;
+                type = InvalidArchiveType;
             }
             else
             {
-                _type = SevenZip;
+                type = SevenZip;
             }
         }
         break;
@@ -256,20 +310,19 @@ void Archive::reset(const QString &filename)
         {
             if (!_programExists[SevenZip] || !_sevenZipRarExists)
             {
-                _type = InvalidArchiveType;
+                type = InvalidArchiveType;
             }
             else
             {
-                _type = SevenZip;
+                type = SevenZip;
             }
         }
         break;
-    case InvalidArchiveType:
+    default:
         break;
     }
 
-    debug()<<"Archive type"<<_type;
-    Q_ASSERT(_type != InvalidArchiveType);
+    return type;
 }
 
 const QString &Archive::filename() const
@@ -282,7 +335,145 @@ Archive::Type Archive::type() const
     return _type;
 }
 
+/**
+ * Empty for packs and folders, which are read directly.
+ */
 const QString &Archive::programPath() const
 {
-    return _programPaths[_type];
+    static const QString NONE;
+    return _type < NUM_PROGRAMS ? _programPaths[_type] : NONE;
+}
+
+/**
+ * A hex string, safe to use as a file name.
+ */
+const QByteArray &Archive::identity() const
+{
+    return _identity;
+}
+
+/**
+ * For a folder, from Indexer::folderIdentity() once it's listed.
+ */
+void Archive::setIdentity(const QByteArray &identity)
+{
+    _identity = identity;
+}
+
+/**
+ * The open reading pack, if the type is Pack.
+ */
+const PackFile &Archive::pack() const
+{
+    return _pack;
+}
+
+/**
+ * The page to open at, when a loose image was opened (otherwise empty).
+ */
+const QByteArray &Archive::startPageName() const
+{
+    return _startPageName;
+}
+
+/**
+ * Arguments for writing one entry to standard output. 7z reads the entry
+ * name from a list file, which has to outlive the process.
+ *
+ * @todo Use correct path on Windows to find 7z
+ */
+QStringList Archive::extractionArguments(
+    const QByteArray &pageFilename,
+    QTemporaryFile &listFile) const
+{
+    return extractionArguments(_type, _filename, pageFilename, listFile);
+}
+
+/**
+ * For use off the main thread, where the archive itself can't be shared.
+ */
+QStringList Archive::extractionArguments(
+    Type type,
+    const QString &filename,
+    const QByteArray &pageFilename,
+    QTemporaryFile &listFile)
+{
+    QStringList args;
+
+    switch (type)
+    {
+        case SevenZip:
+            args<<"e"<<"-so";
+#ifdef Q_OS_WIN32
+            // Specify the list file encoding on Windows
+            args<<"-scsDOS";
+#endif
+            break;
+        case Tar:
+            args<<"-xOf";
+            break;
+        case Zip:
+            args<<"-p";
+            break;
+        case Rar:
+            args<<"p"<<"-ierr";
+            // Note: With "-ierr", the header info is put into stderr (and not into the image data)
+            break;
+        default:
+            Q_ASSERT(false);
+    }
+
+    // Pass in the archive file name
+    args<<filename;
+
+    // Pass in the name of the compressed file
+    if (type == SevenZip)
+    {
+        listFile.open();
+        listFile.write(pageFilename);
+        listFile.write("\n");
+        listFile.flush();
+
+        args<<("-i@" + listFile.fileName());
+    }
+    else
+    {
+        args<<QString::fromLocal8Bit(pageFilename);
+    }
+
+    return args;
+}
+
+/**
+ * Extract a whole entry, blocking (so only off the main thread). Returns an
+ * empty array if the extracter fails or takes longer than @a timeout ms.
+ */
+QByteArray Archive::extract(
+    Type type,
+    const QString &filename,
+    const QString &programPath,
+    const QByteArray &pageFilename,
+    int timeout)
+{
+    // Folders are read directly
+    if (type == Directory)
+    {
+        QFile file(QDir(filename).filePath(QFile::decodeName(pageFilename)));
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    QTemporaryFile listFile;
+    QProcess extracter;
+
+    extracter.start(programPath, extractionArguments(type, filename, pageFilename, listFile));
+
+    if (!extracter.waitForFinished(timeout))
+    {
+        debug()<<"Extraction timed out"<<filename<<pageFilename;
+        extracter.kill();
+        extracter.waitForFinished();
+        return QByteArray();
+    }
+
+    return extracter.readAllStandardOutput();
 }
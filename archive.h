@@ -5,6 +5,10 @@
 #include <QSettings>
 #include <QStringList>
 
+#include "packfile.h"
+
+class QTemporaryFile;
+
 class Archive : public QObject
 {
     Q_OBJECT
@@ -16,28 +20,66 @@ public:
         Tar,
         Zip,
         Rar,
+        Pack,
+        Directory,
         InvalidArchiveType
     };
 
+    /** Types read by an external program (the rest are read directly) */
+    static const int NUM_PROGRAMS = Pack;
+
+    /** An archive file extension, and the type it's read as */
+    struct Extension
+    {
+        const char *ext;
+        Type type;
+    };
+
+    /** Every archive extension, ending with an empty one */
+    static const Extension EXTENSIONS[];
+
 public:
     Archive(QObject *parent = NULL);
     ~Archive();
 
     void testPrograms();
 
-    void reset(const QString &_fileName);
+    bool reset(const QString &_fileName);
+    Type typeOf(const QString &filename) const;
 
     const QString &filename() const;
     Type type() const;
     const QString &programPath() const;
+    const QByteArray &identity() const;
+    void setIdentity(const QByteArray &identity);
+    const PackFile &pack() const;
+    const QByteArray &startPageName() const;
+
+    QStringList extractionArguments(
+        const QByteArray &pageFilename,
+        QTemporaryFile &listFile) const;
+    static QStringList extractionArguments(
+        Type type,
+        const QString &filename,
+        const QByteArray &pageFilename,
+        QTemporaryFile &listFile);
+    static QByteArray extract(
+        Type type,
+        const QString &filename,
+        const QString &programPath,
+        const QByteArray &pageFilename,
+        int timeout);
 
 private:
     QSettings _settings;
-    bool _programExists[InvalidArchiveType];
-    QString _programPaths[InvalidArchiveType];
+    bool _programExists[NUM_PROGRAMS];
+    QString _programPaths[NUM_PROGRAMS];
     bool _sevenZipRarExists;
     QString _filename;
+    QByteArray _identity;
+    QByteArray _startPageName;
     Type _type;
+    PackFile _pack;
 };
 
 #endif
@@ -5,10 +5,13 @@
 
 #include "archive.h"
 #include "debug.h"
+#include "trace.h"
 
 ArchiveLister::ArchiveLister(const Archive &archive, QObject *parent)
     : QObject(parent), _archive(archive)
 {
+    _traceId = -1;
+
     // Connect to the extracter process
     connect(&_process, SIGNAL(readyReadStandardError()),
              this, SLOT(errorText()));
@@ -43,6 +46,12 @@ ArchiveLister::~ArchiveLister()
             _process.kill();
         }
     }
+
+    // End the listing's span, if it was stopped partway
+    if (_traceId != -1)
+    {
+        Trace::asyncEnd("list", _traceId);
+    }
 }
 
 void ArchiveLister::start()
@@ -106,9 +115,20 @@ void ArchiveLister::start()
     }
 
     // Start the process listing
+    _traceId = Trace::newId();
+    Trace::asyncBegin("list", _traceId);
     _process.start(_archive.programPath(), args);
 }
 
+/**
+ * Block until the listing is finished, for use off the main thread. The
+ * signals are still emitted, from inside this call.
+ */
+void ArchiveLister::wait()
+{
+    _process.waitForFinished(-1);
+}
+
 void ArchiveLister::sevenZipParser()
 {
     _currentInputLine.append(_process.readAllStandardOutput());
@@ -150,8 +170,15 @@ void ArchiveLister::sevenZipParserBlock(const QByteArray &block)
         {
             emit entryFound(
                 filename,
-                attributes["Packed Size"].toInt(),
-                attributes["Size"].toInt());
+                attributes["Packed Size"].toLongLong(),
+                attributes["Size"].toLongLong());
+        }
+        else if (FileClassification::isArchiveFile(QString::fromLocal8Bit(filename)))
+        {
+            emit archiveFound(
+                filename,
+                attributes["Packed Size"].toLongLong(),
+                attributes["Size"].toLongLong());
         }
     }
 }
@@ -161,7 +188,7 @@ void ArchiveLister::defaultParser()
     QByteArray output = _process.readAllStandardOutput();
     int newLineIdx;
 
-    int size;
+    qint64 size;
     bool parsed;
 
     //debug()<<"Got output:"<<QString(output);
@@ -209,7 +236,7 @@ void ArchiveLister::defaultParser()
         if (data.front() != "0")
         {
             // Store the file size
-            size = data.front().toInt(&parsed);
+            size = data.front().toLongLong(&parsed);
             Q_ASSERT(parsed);
 
             // Skip the rest of the fields before name field
@@ -227,9 +254,12 @@ void ArchiveLister::defaultParser()
             // Put the name back together and trim whitespace
             QString filename = data.join(" ").trimmed();
 
-            if (FileClassification::isImageFile(filename.toLocal8Bit()))
+            bool image = FileClassification::isImageFile(filename.toLocal8Bit());
+            bool archive = !image && FileClassification::isArchiveFile(filename);
+
+            if (image || archive)
             {
-                // This is an image file
+                // This is an image file (or an archive of them)
 
                 // Unzip has huge problems with filenames, so try to clean them up a bit
                 // For example, it can't handle '[' or ']' in the path
@@ -239,7 +269,16 @@ void ArchiveLister::defaultParser()
                     filename = cleanZipFilename(filename);
                 }
 
-                emit entryFound(filename.toLocal8Bit(), size, 0);
+                // Tar entries aren't compressed individually, and unzip's
+                // short listing only gives the uncompressed length
+                if (image)
+                {
+                    emit entryFound(filename.toLocal8Bit(), size, size);
+                }
+                else
+                {
+                    emit archiveFound(filename.toLocal8Bit(), size, size);
+                }
             }
         }
 
@@ -326,14 +365,27 @@ void ArchiveLister::rarParserText()
                 // Check if the previous entry was a directory
                 // Note: all directories will have size 0
                 // And check that the file is an image
-                QString size = data[1];
+                QString size = data[0];
+                QString packedSize = data[1];
 
-                if (size != "0" && FileClassification::isImageFile(_rarFileName.toLocal8Bit()))
+                bool image = FileClassification::isImageFile(_rarFileName.toLocal8Bit());
+                bool archive = !image && FileClassification::isArchiveFile(_rarFileName);
+
+                if (size != "0" && (image || archive))
                 {
-                    int parsedSize = size.toInt(&parsed);
+                    qint64 parsedSize = size.toLongLong(&parsed);
+                    Q_ASSERT(parsed);
+                    qint64 parsedPackedSize = packedSize.toLongLong(&parsed);
                     Q_ASSERT(parsed);
 
-                    emit entryFound(_rarFileName.toLocal8Bit(), parsedSize, 0);
+                    if (image)
+                    {
+                        emit entryFound(_rarFileName.toLocal8Bit(), parsedPackedSize, parsedSize);
+                    }
+                    else
+                    {
+                        emit archiveFound(_rarFileName.toLocal8Bit(), parsedPackedSize, parsedSize);
+                    }
                 }
             }
 
@@ -368,6 +420,8 @@ void ArchiveLister::finished(int exitCode, QProcess::ExitStatus exitStatus)
 
     // Note: pages might not be in a good order, depending on the decompressor's
     //  "sorting" logic
+    Trace::asyncEnd("list", _traceId);
+    _traceId = -1;
     emit finished();
 }
 
@@ -26,9 +26,11 @@ public:
     ~ArchiveLister();
 
     void start();
+    void wait();
 
 signals:
-    void entryFound(const QByteArray &filename, int compressedSize, int uncompressedSize);
+    void entryFound(const QByteArray &filename, qint64 compressedSize, qint64 uncompressedSize);
+    void archiveFound(const QByteArray &filename, qint64 compressedSize, qint64 uncompressedSize);
     void finished();
 
 private slots:
@@ -60,6 +62,8 @@ private:
     QByteArray _currentInputLine;
 
     QString _rarFileName;
+
+    qint64 _traceId;
 };
 
 #endif
@@ -2,13 +2,25 @@
 
 #include <QThread>
 #include <QThreadPool>
+#include <QtConcurrentRun>
 
 #include "debug.h"
+#include "archive.h"
 #include "decoder.h"
+#include "diskcache.h"
+#include "strategist.h"
+#include "trace.h"
 
-Artificer::Artificer(const Archive &archive, const Indexer &indexer, Strategist &strategist, QObject *parent)
-    : QObject(parent), _archive(archive), _indexer(indexer), _strategist(strategist)
+const double Artificer::MAX_RESCALE_ENLARGEMENT = 1.1;
+
+Artificer::Artificer(const Archive &archive, const Indexer &indexer, Strategist &strategist, DiskCache &diskCache, QObject *parent)
+    : QObject(parent), _archive(archive), _indexer(indexer), _strategist(strategist), _diskCache(diskCache),
+    _extractionRates(STATS_DECODES), _decodeTimes(STATS_DECODES)
 {
+    _warmStart = true;
+    _decodesStarted = 0;
+    _decodesCancelled = 0;
+
     // Set up thread pool
     QThreadPool::globalInstance()->setMaxThreadCount(DECODE_THREADS);
     //debug()<<"Ideal threads:"<<QThread::idealThreadCount();
@@ -32,6 +44,23 @@ void Artificer::reset()
         delete decoder;
     }
     _cancelled.clear();
+
+    // Rescales are quick, so let them finish and drop the results
+    foreach (QFutureWatcher<QImage> *watcher, _rescales.keys())
+    {
+        watcher->waitForFinished();
+        delete watcher;
+    }
+    _rescales.clear();
+}
+
+/**
+ * Whether to use the disk cache. A cold start neither loads nor stores pages,
+ * so every page is decoded as on the very first opening.
+ */
+void Artificer::setWarmStart(bool enabled)
+{
+    _warmStart = enabled;
 }
 
 void Artificer::decodePages(int page0, int page1)
@@ -68,38 +97,224 @@ void Artificer::decodePages(QList<int> pages)
             decoder->cancel();
             _running.removeOne(decoder);
             _cancelled<<decoder;
+            _decodesCancelled++;
         }
     }
 
     // Queue the new pages if needed
     // TODO: Reduce overload when changing pages rapidly, spawning
     //   processes without limit
+    QList<int> cachedPages;
+    QList<QImage> cachedImages;
+
     foreach (int request, pages)
     {
+        // Already being resampled to the size it's wanted at
+        if (isRescaling(request))
+        {
+            continue;
+        }
+
+        // Packs hold the pages ready to show
+        QImage packed;
+
+        if (_archive.type() == Archive::Pack)
+        {
+            packed = _archive.pack().page(request);
+
+            if (packed.size() == _strategist.pageLayout(request).size())
+            {
+                cachedPages<<request;
+                cachedImages<<packed;
+                continue;
+            }
+        }
+
+        // Use the disk cache when the page's size is settled
+        if (_warmStart && _strategist.isFullPageSizeKnown(request))
+        {
+            QImage cached = _diskCache.load(_archive.identity(), request,
+                _strategist.pageLayout(request).size());
+
+            if (!cached.isNull())
+            {
+                cachedPages<<request;
+                cachedImages<<cached;
+                continue;
+            }
+        }
+
+        // Shown at another size than the pack's, which is still the best source
+        if (!packed.isNull())
+        {
+            rescalePage(request, packed, _strategist.pageLayout(request).size());
+            continue;
+        }
+
         // Create the decoder
         Decoder *decoder = new Decoder(this);
         connect(decoder,
-            SIGNAL(done(Decoder*, int, QPixmap)),
-            SLOT(decoderDone(Decoder*, int, QPixmap)));
+            SIGNAL(done(Decoder*, int, QImage)),
+            SLOT(decoderDone(Decoder*, int, QImage)));
         connect(decoder,
             SIGNAL(cancelled(Decoder *)),
             SLOT(decoderCancelled(Decoder *)));
         _running<<decoder;
+        _decodesStarted++;
 
         // Start it
-        decoder->decode(_archive, _indexer, _strategist, request);
+        decoder->decode(_indexer, _strategist, request);
+    }
+
+    // Hand over the cached pages once the decoders are settled (they aren't
+    // decodes, so they have their own signal)
+    for (int i = 0; i < cachedPages.size(); i++)
+    {
+        emit pageCached(cachedPages[i], cachedImages[i]);
+    }
+}
+
+/**
+ * Shrinking, or enlarging only a little, looks as good as a fresh decode.
+ */
+bool Artificer::canRescale(const QSize &from, const QSize &to)
+{
+    return !to.isEmpty()
+        && to.width() <= int(from.width() * MAX_RESCALE_ENLARGEMENT)
+        && to.height() <= int(from.height() * MAX_RESCALE_ENLARGEMENT);
+}
+
+/**
+ * Resample an already decoded page to a new size on a worker thread, rather
+ * than extracting and decoding it again. The result arrives through
+ * pageRescaled(), so it isn't taken for a decode.
+ */
+void Artificer::rescalePage(int index, const QImage &image, const QSize &size)
+{
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, SIGNAL(finished()), SLOT(rescaleFinished()));
+    _rescales[watcher] = index;
+
+    watcher->setFuture(QtConcurrent::run(&Artificer::rescale, image, size));
+}
+
+QImage Artificer::rescale(QImage image, QSize size)
+{
+    TraceScope scope("rescale");
+    return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+void Artificer::rescaleFinished()
+{
+    QFutureWatcher<QImage> *watcher = static_cast<QFutureWatcher<QImage> *>(sender());
+    Q_ASSERT(_rescales.contains(watcher));
+
+    int index = _rescales.take(watcher);
+    QImage image = watcher->result();
+    watcher->deleteLater();
+
+    // Keep it for next time
+    storePage(index, image);
+
+    // Notify the steward
+    emit pageRescaled(index, image);
+}
+
+/**
+ * Whether the page is on its way, from a decode or a resample.
+ */
+bool Artificer::isDecoding(int page) const
+{
+    foreach (Decoder *decoder, _running)
+    {
+        if (decoder->pageNum() == page)
+        {
+            return true;
+        }
+    }
+
+    return isRescaling(page);
+}
+
+/**
+ * Only pages at the size they're laid out at are worth keeping on disk (a
+ * decode started on a guessed size, or a resample for a layout that's since
+ * changed, would never be loaded).
+ */
+void Artificer::storePage(int index, const QImage &image)
+{
+    if (_warmStart && image.size() == _strategist.pageLayout(index).size())
+    {
+        _diskCache.store(_archive.identity(), index, image);
     }
 }
 
-void Artificer::decoderDone(Decoder *decoder, int index, QPixmap pixmap)
+bool Artificer::isRescaling(int page) const
+{
+    foreach (int index, _rescales)
+    {
+        if (index == page)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int Artificer::runningCount() const
 {
+    return _running.size();
+}
+
+int Artificer::cancellingCount() const
+{
+    return _cancelled.size();
+}
+
+int Artificer::decodesStarted() const
+{
+    return _decodesStarted;
+}
+
+int Artificer::decodesCancelled() const
+{
+    return _decodesCancelled;
+}
+
+/**
+ * In MB/s of uncompressed page data.
+ */
+const Distribution &Artificer::extractionRates() const
+{
+    return _extractionRates;
+}
+
+const Distribution &Artificer::decodeTimes() const
+{
+    return _decodeTimes;
+}
+
+void Artificer::decoderDone(Decoder *decoder, int index, QImage image)
+{
+    // Record how it went
+    double extractionMs = decoder->extractionMs();
+    if (extractionMs > 0.0)
+    {
+        _extractionRates.addSample(double(decoder->bytes()) / (1024.0 * 1024.0) / (extractionMs / 1000.0));
+    }
+    _decodeTimes.addSample(decoder->decodeMs());
+
+    // Keep it for next time
+    storePage(index, image);
+
     // Delete the decoder
     bool removed = _running.removeOne(decoder);
     delete decoder;
     Q_ASSERT(removed);
 
     // Notify the steward
-    emit pageDecoded(index, pixmap);
+    emit pageDecoded(index, image);
 }
 
 void Artificer::decoderCancelled(Decoder *decoder)
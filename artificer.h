@@ -3,10 +3,15 @@
 
 #include <QObject>
 
-#include <QPixmap>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMap>
+
+#include "distribution.h"
 
 class Archive;
 class Decoder;
+class DiskCache;
 class Indexer;
 class Strategist;
 
@@ -15,33 +20,63 @@ class Artificer : public QObject
     Q_OBJECT
 
 public:
-    Artificer(const Archive &archive, const Indexer &indexer, Strategist &strategist, QObject *parent = NULL);
+    Artificer(const Archive &archive, const Indexer &indexer, Strategist &strategist, DiskCache &diskCache, QObject *parent = NULL);
     ~Artificer();
 
     void reset();
+    void setWarmStart(bool enabled);
 
     void decodePages(int page0, int page1);
+    void decodePages(QList<int> pages);
+    bool isDecoding(int page) const;
+
+    static bool canRescale(const QSize &from, const QSize &to);
+    void rescalePage(int index, const QImage &image, const QSize &size);
+
+    int runningCount() const;
+    int cancellingCount() const;
+    int decodesStarted() const;
+    int decodesCancelled() const;
+
+    const Distribution &extractionRates() const;
+    const Distribution &decodeTimes() const;
 
 signals:
-    void pageDecoded(int index, QPixmap pixmap);
+    void pageDecoded(int index, QImage image);
+    void pageRescaled(int index, QImage image);
+    void pageCached(int index, QImage image);
 
 private slots:
-    void decoderDone(Decoder *decoder, int index, QPixmap pixmap);
+    void decoderDone(Decoder *decoder, int index, QImage image);
     void decoderCancelled(Decoder *decoder);
+    void rescaleFinished();
 
 private:
-    void decodePages(QList<int> pages);
+    void storePage(int index, const QImage &image);
+    bool isRescaling(int page) const;
+    static QImage rescale(QImage image, QSize size);
 
 private:
     static const int DECODE_THREADS = 3;
+    static const int STATS_DECODES = 100;
+    static const double MAX_RESCALE_ENLARGEMENT;
 
 private:
     const Archive &_archive;
     const Indexer &_indexer;
     Strategist &_strategist;
+    DiskCache &_diskCache;
 
     QList<Decoder *> _running;
     QList<Decoder *> _cancelled;
+    QMap<QFutureWatcher<QImage> *, int> _rescales;
+
+    bool _warmStart;
+
+    int _decodesStarted;
+    int _decodesCancelled;
+    Distribution _extractionRates;
+    Distribution _decodeTimes;
 };
 
 #endif
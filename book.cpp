@@ -28,39 +28,53 @@ void Book::reset(int numPages)
 
     _importantPageIsFirst = true;
 
-    // Set resize the info list
-    _info.resize(_numPages);
+    // No dual pages, so one section paired from the first page
+    _dual.clear();
+    _parity.clear();
+    _parity[0] = 0;
 
-    // Set the dual info
-    for (int i = 0; i < _numPages; i++)
-    {
-        _info[i].dual = false;
-    }
+    // Notify changed
+    emit changed();
+}
+
+Book::~Book()
+{
+}
+
+/**
+ * Add pages to the end of the book, keeping the current pages and what's
+ * known about dual pages. The last section just gets longer (or a new one
+ * starts after a dual page), so a solitary last page can now be paired.
+ */
+void Book::extend(int numPages)
+{
+    Q_ASSERT(numPages >= _numPages);
 
-    // Initialize the pairings
-    for (int i = 0; i < _numPages; i += 2)
+    // An empty book is just started over
+    if (_numPages == 0)
     {
-        _info[i].pair = Next;
+        reset(numPages);
+        return;
     }
 
-    for (int i = 1; i < _numPages; i += 2)
+    // After a dual last page, the new pages start their own section
+    if (isDual(_numPages - 1) && numPages > _numPages)
     {
-        _info[i].pair = Previous;
+        _parity[_numPages] = _numPages % 2;
     }
 
-    if (_numPages % 2 == 1)
+    _numPages = numPages;
+
+    // Pair the last page shown with its new neighbour
+    if (_page1 == -1 && pair(_page0) == Next)
     {
-        _info.back().pair = None;
+        _page1 = _page0 + 1;
     }
 
     // Notify changed
     emit changed();
 }
 
-Book::~Book()
-{
-}
-
 void Book::next()
 {
     Q_ASSERT(_page0 < _numPages - 1 && _page1 < _numPages - 1);
@@ -151,7 +165,7 @@ void Book::shiftNext()
     bool shift = true;
 
     // Check that not displaying a dual page
-    if (_info[_page0].dual)
+    if (isDual(_page0))
     {
         shift = false;
     }
@@ -170,7 +184,7 @@ void Book::shiftNext()
     }
 
     // Check that the next page isn't dual
-    if (_info[lastPage + 1].dual)
+    if (isDual(lastPage + 1))
     {
         shift = false;
     }
@@ -189,42 +203,10 @@ void Book::shiftNext()
     // The important page is the second (not see yet) page
     _importantPageIsFirst = false;
 
-    // Find the start of this section
-    int boundary;
-
-    for (boundary = _page0 - 1; boundary >= 0; boundary--)
-    {
-        if (_info[boundary].dual)
-        {
-            break;
-        }
-    }
-
-    // Reset all pairs until the next dual page
-
-    // If the section starts at a page that would be paired to the previous
-    // page, skip over it
-    int i = boundary + 1;
-
-    if (i % 2 == _page1 % 2)
-    {
-        _info[i].pair = None;
-        i++;
-    }
-
-    // Continue with all pairs until the section end
-    for (; i < _numPages - 1
-         && !_info[i].dual && !_info[i + 1].dual; i += 2)
-    {
-        _info[i].pair = Next;
-        _info[i + 1].pair = Previous;
-    }
-
-    // If section ends in a solitary page, account for it
-    if (i < _numPages && !_info[i].dual)
-    {
-        _info[i].pair = None;
-    }
+    // Reset all pairs in this section to start from the current pages
+    // (if the section starts at a page that would be paired to the previous
+    // page, it becomes solitary)
+    _parity[sectionStart(_page0)] = _page0 % 2;
 
     // Notify changed
     emit changed();
@@ -253,20 +235,27 @@ void Book::setDual(int page)
     int initialPage0 = _page0;
     int initialPage1 = _page1;
 
-    // If the page was paired, unpair it
-    if (_info[page].pair == Previous)
-    {
-        _info[page - 1].pair = None;
-        _info[page].pair = None;
-    }
-    else if (_info[page].pair == Next)
+    // Split the section at the page, unpairing it (the pages after it keep the
+    // same parity)
+    if (!isDual(page))
     {
-        _info[page + 1].pair = None;
-        _info[page].pair = None;
-    }
+        int start = sectionStart(page);
+        int end = sectionEnd(page);
+        int parity = _parity[start];
+
+        if (start == page)
+        {
+            _parity.erase(start);
+        }
+
+        if (page < end)
+        {
+            _parity[page + 1] = parity;
+        }
 
-    // Set the page as dual
-    _info[page].dual = true;
+        // Set the page as dual
+        _dual.insert(page);
+    }
 
     // If hit a page of the current two, switch to single
     if (_page1 != -1 && (page == _page0 || page == _page1))
@@ -289,8 +278,8 @@ void Book::setDual(int page)
 
     // The page needs to be before the second last page
     // And the next two pages need to be non-dual and unpaired
-    if (page < _numPages - 2 && !_info[page + 1].dual && !_info[page + 2].dual
-            && _info[page + 1].pair == None)
+    if (page < _numPages - 2 && !isDual(page + 1) && !isDual(page + 2)
+            && pair(page + 1) == None)
     {
         changeNeeded = true;
     }
@@ -300,15 +289,8 @@ void Book::setDual(int page)
     // between them, cancel the change
     if (changeNeeded && _page0 > page)
     {
-        bool interveningDualPage = false;
-
-        for (int i = page + 1; i < _page0; i++)
-        {
-            if (_info[i].dual)
-            {
-                interveningDualPage = true;
-            }
-        }
+        set<int>::const_iterator nextDual = _dual.upper_bound(page);
+        bool interveningDualPage = (nextDual != _dual.end() && *nextDual < _page0);
 
         if (!interveningDualPage)
         {
@@ -317,44 +299,25 @@ void Book::setDual(int page)
     }
 
     // If the change is needed, reset the parity for the pages after the new
-    // dual page
+    // dual page (until a dual page or the end of the book is reached)
     if (changeNeeded)
     {
-        // Keep reseting pairs until a dual page or the end of the book is
-        // reached
-        int i;
-
-        for (i = page + 1; i < _numPages - 1 && !_info[i].dual
-                && !_info[i + 1].dual; i += 2)
-        {
-            _info[i].pair = Next;
-            _info[i + 1].pair = Previous;
-        }
-
-        // Make sure the last page in the sequence is solitary (it's dual or
-        // the next is dual, or it's the last page)
-        if (i < _numPages && !_info[i].dual)
-        {
-            _info[i].pair = None;
-        }
+        _parity[page + 1] = (page + 1) % 2;
     }
 
     // Test for stranding behind
     if (page > 1)
     {
-        bool solitarySingle0 = !_info[page - 2].dual
-                && _info[page - 2].pair == None;
-        bool solitarySingle1 = !_info[page - 1].dual
-                && _info[page - 1].pair == None;
+        bool solitarySingle0 = !isDual(page - 2) && pair(page - 2) == None;
+        bool solitarySingle1 = !isDual(page - 1) && pair(page - 1) == None;
 
         if (solitarySingle0 && solitarySingle1)
         {
             // The preceding page should be dual
-            Q_ASSERT(page == 2 || _info[page - 3].dual);
+            Q_ASSERT(page == 2 || isDual(page - 3));
 
             // Pair the two stranded pages
-            _info[page - 2].pair = Next;
-            _info[page - 1].pair = Previous;
+            _parity[page - 2] = (page - 2) % 2;
 
             // Check if the current pages need pairing
             if (_page0 == page - 2 || _page0 == page - 1)
@@ -369,19 +332,17 @@ void Book::setDual(int page)
     // Test for stranding forward
     if (!_importantPageIsFirst &&_page0 == page + 1 && page < _numPages - 2)
     {
-        bool solitarySingle0 = !_info[_page0].dual && _page1 == -1;
-        bool solitarySingle1 = !_info[page + 2].dual
-                && _info[page + 2].pair == None;
+        bool solitarySingle0 = !isDual(_page0) && _page1 == -1;
+        bool solitarySingle1 = !isDual(page + 2) && pair(page + 2) == None;
 
         if (solitarySingle0 && solitarySingle1)
         {
             // The proceding page should be dual
-            Q_ASSERT(page == _numPages - 3 || _info[page + 3].dual);
+            Q_ASSERT(page == _numPages - 3 || isDual(page + 3));
 
             // Pair the two stranded pages
             _page1 = _page0 + 1;
-            _info[_page0].pair = Next;
-            _info[_page1].pair = Previous;
+            _parity[_page0] = _page0 % 2;
         }
     }
 
@@ -398,7 +359,7 @@ void Book::setDual(int page)
 bool Book::isDual(int page)
 {
     Q_ASSERT(page >= 0 && page < _numPages);
-    return _info[page].dual;
+    return _dual.count(page) > 0;
 }
 
 int Book::page0()
@@ -415,13 +376,13 @@ int Book::pairedPage(int page)
 {
     Q_ASSERT(page >= 0 && page < _numPages);
 
-    const Pair &pair = _info[page].pair;
+    Pair pagePair = pair(page);
 
-    if (pair == Previous)
+    if (pagePair == Previous)
     {
         return page - 1;
     }
-    else if (pair == None)
+    else if (pagePair == None)
     {
         return -1;
     }
@@ -435,7 +396,7 @@ int Book::pairedPageOffset(int page)
 {
     Q_ASSERT(page >= 0 && page < _numPages);
 
-    return (int) _info[page].pair;
+    return (int) pair(page);
 }
 
 int Book::numPages()
@@ -452,3 +413,54 @@ bool Book::isPreviousEnabled()
 {
     return _page0 > 0;
 }
+
+/**
+ * Pages matching the section's parity pair forward, and the others backward,
+ * as long as the pair is in the same section.
+ */
+Book::Pair Book::pair(int page)
+{
+    if (isDual(page))
+    {
+        return None;
+    }
+
+    int start = sectionStart(page);
+
+    if ((page - _parity[start]) % 2 == 0)
+    {
+        return page + 1 <= sectionEnd(page) ? Next : None;
+    }
+    else
+    {
+        return page - 1 >= start ? Previous : None;
+    }
+}
+
+/**
+ * Every section start (the first page, and each non-dual page after a dual
+ * page) has a parity, so the closest one at or before a non-dual page
+ * starts its section.
+ */
+int Book::sectionStart(int page)
+{
+    map<int, int>::const_iterator start = _parity.upper_bound(page);
+    Q_ASSERT(start != _parity.begin());
+    --start;
+
+    return start->first;
+}
+
+int Book::sectionEnd(int page)
+{
+    set<int>::const_iterator nextDual = _dual.upper_bound(page);
+
+    if (nextDual == _dual.end())
+    {
+        return _numPages - 1;
+    }
+    else
+    {
+        return *nextDual - 1;
+    }
+}
@@ -3,9 +3,11 @@
 
 #include <QObject>
 
-#include <vector>
+#include <map>
+#include <set>
 
-using std::vector;
+using std::map;
+using std::set;
 
 /**
  * @brief A model of the physical book: what page it's open to, which pages are
@@ -38,6 +40,13 @@ using std::vector;
  * for them to be viewed together due to the nature of the shifting operation.
  * When dual page is found, this condition must always be maintained.
  *
+ * Pairings aren't stored per page. The non-dual pages between two dual pages
+ * form a section, and every section pairs its pages the same way, from one
+ * parity: pages matching the parity pair with the next page, and the others
+ * with the previous one (pages at the section edges can be left solitary).
+ * So only the dual pages and the parity of each section are kept, making
+ * learning a dual page and finding a pair logarithmic in the book size.
+ *
  * @todo Allow for un-setting pages as dual, in case a prediction is wrong
  */
 class Book : public QObject
@@ -49,6 +58,7 @@ public:
     ~Book();
 
     void reset(int numPages);
+    void extend(int numPages);
 
     void next();
     void previous();
@@ -75,15 +85,16 @@ signals:
 
 private:
     enum Pair {Previous = -1, None, Next};
-    struct Info
-    {
-        bool dual;
-        Pair pair;
-    };
+
+private:
+    Pair pair(int page);
+    int sectionStart(int page);
+    int sectionEnd(int page);
 
 private:
     int _numPages;
-    vector<Info> _info;
+    set<int> _dual;
+    map<int, int> _parity;
     int _page0;
     int _page1;
     bool _importantPageIsFirst;
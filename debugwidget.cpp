@@ -0,0 +1,164 @@
+#include "debugwidget.h"
+
+#include <QBoxLayout>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QLabel>
+#include <QPushButton>
+
+#include "artificer.h"
+#include "debug.h"
+#include "depot.h"
+#include "diskcache.h"
+#include "distribution.h"
+#include "latencymeter.h"
+#include "projector.h"
+#include "steward.h"
+
+const int DebugWidget::REFRESH_INTERVAL = 500;
+
+DebugWidget::DebugWidget(Steward &steward, QWidget *parent)
+    : QWidget(parent, Qt::Tool), _steward(steward)
+{
+    setWindowTitle("Yomikata Debug");
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    // Figures
+    _figures = new QFormLayout();
+    mainLayout->addLayout(_figures);
+
+    _spread = addRow("Current spread");
+    _decoders = addRow("Decoders");
+    _depot = addRow("Depot");
+    _packed = addRow("Packed");
+    _diskCache = addRow("Disk cache");
+    _extraction = addRow("Extraction");
+    _decode = addRow("Decode");
+    _wrongSize = addRow("Wrong size decodes");
+    _frames = addRow("Frames");
+    _latency = addRow("Page turn latency");
+
+    // Export
+    QPushButton *exportButton = new QPushButton("Export latencies...", this);
+    connect(exportButton, SIGNAL(clicked()), SLOT(exportLatency()));
+    mainLayout->addWidget(exportButton);
+
+    // Refresh periodically
+    _refreshTimer.setInterval(REFRESH_INTERVAL);
+    connect(&_refreshTimer, SIGNAL(timeout()), SLOT(refresh()));
+}
+
+DebugWidget::~DebugWidget()
+{
+}
+
+QLabel *DebugWidget::addRow(const QString &name)
+{
+    QLabel *label = new QLabel(this);
+    label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    _figures->addRow(name, label);
+    return label;
+}
+
+void DebugWidget::refresh()
+{
+    const char *SPREAD_SOURCES[] = {"Cache", "Scaled from cache", "Prefetched (in flight)", "Cold decode"};
+
+    _spread->setText(SPREAD_SOURCES[_steward.spreadSource()]);
+
+    // Decoders
+    const Artificer &artificer = _steward.artificer();
+
+    _decoders->setText(QString("%1 running, %2 winding down\n%3 started, %4 cancelled")
+        .arg(artificer.runningCount())
+        .arg(artificer.cancellingCount())
+        .arg(artificer.decodesStarted())
+        .arg(artificer.decodesCancelled()));
+
+    _extraction->setText(describe(artificer.extractionRates(), "MB/s"));
+    _decode->setText(describe(artificer.decodeTimes(), "ms"));
+
+    int currentDecodes = _steward.currentDecodes();
+    int wrongSizeDecodes = _steward.wrongSizeDecodes();
+
+    _wrongSize->setText(QString("%1 of %2 (%3%)")
+        .arg(wrongSizeDecodes)
+        .arg(currentDecodes)
+        .arg(currentDecodes > 0 ? 100 * wrongSizeDecodes / currentDecodes : 0));
+
+    // Cache
+    const Depot &depot = _steward.depot();
+    int lookups = depot.hits() + depot.scaledHits() + depot.misses();
+
+    _depot->setText(QString("%1 pages, %2 MB\n%3% hit, %4% scaled, %5% miss")
+        .arg(depot.pagesHeld())
+        .arg(double(depot.bytesUsed()) / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(lookups > 0 ? 100 * depot.hits() / lookups : 0)
+        .arg(lookups > 0 ? 100 * depot.scaledHits() / lookups : 0)
+        .arg(lookups > 0 ? 100 * depot.misses() / lookups : 0));
+
+    _packed->setText(QString("%1 pages, %2 MB (%3:1), %4 hits\nUnpack %5")
+        .arg(depot.pagesPacked())
+        .arg(double(depot.packedBytesUsed()) / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(depot.compressionRatio(), 0, 'f', 1)
+        .arg(depot.packedHits())
+        .arg(describe(depot.unpackTimes(), "ms")));
+
+    const DiskCache &diskCache = _steward.diskCache();
+    int diskLookups = diskCache.hits() + diskCache.misses();
+
+    _diskCache->setText(QString("%1 hits, %2 misses (%3% hit)")
+        .arg(diskCache.hits())
+        .arg(diskCache.misses())
+        .arg(diskLookups > 0 ? 100 * diskCache.hits() / diskLookups : 0));
+
+    // Frames
+    const Projector &projector = _steward.projector();
+
+    _frames->setText(QString("%1 fps\nPaint %2")
+        .arg(projector.framesPerSecond(), 0, 'f', 1)
+        .arg(describe(projector.paintTimes(), "ms")));
+
+    // Latency
+    const LatencyMeter &latency = _steward.latency();
+
+    _latency->setText(QString("Input to decoded: %1\nInput to painted: %2\nTurns: %3 (%4 overtaken)")
+        .arg(describe(latency.inputToDecoded(), "ms"))
+        .arg(describe(latency.inputToPainted(), "ms"))
+        .arg(latency.sequence())
+        .arg(latency.dropped()));
+}
+
+void DebugWidget::exportLatency()
+{
+    QString filename = QFileDialog::getSaveFileName(this, "Export Latencies", "latency.csv", "CSV (*.csv)");
+
+    if (!filename.isEmpty())
+    {
+        _steward.latency().exportCsv(filename);
+    }
+}
+
+void DebugWidget::showEvent(QShowEvent *event)
+{
+    refresh();
+    _refreshTimer.start();
+    QWidget::showEvent(event);
+}
+
+void DebugWidget::hideEvent(QHideEvent *event)
+{
+    _refreshTimer.stop();
+    QWidget::hideEvent(event);
+}
+
+QString DebugWidget::describe(const Distribution &distribution, const QString &unit)
+{
+    return QString("p50 %1 %5, p90 %2 %5, p99 %3 %5 (%4 samples)")
+        .arg(distribution.percentile(0.5), 0, 'f', 1)
+        .arg(distribution.percentile(0.9), 0, 'f', 1)
+        .arg(distribution.percentile(0.99), 0, 'f', 1)
+        .arg(distribution.count())
+        .arg(unit);
+}
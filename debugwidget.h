@@ -0,0 +1,57 @@
+#ifndef DEBUGWIDGET_H
+#define DEBUGWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+
+class QFormLayout;
+class QLabel;
+
+class Distribution;
+class Steward;
+
+/**
+ * @brief Live performance figures from the steward.
+ *
+ * Only refreshes while shown; the figures themselves are plain counters and
+ * sample buffers kept by each component.
+ */
+class DebugWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    DebugWidget(Steward &steward, QWidget *parent = NULL);
+    ~DebugWidget();
+
+private slots:
+    void refresh();
+    void exportLatency();
+
+private:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
+    QLabel *addRow(const QString &name);
+
+    static QString describe(const Distribution &distribution, const QString &unit);
+
+private:
+    static const int REFRESH_INTERVAL;
+
+    Steward &_steward;
+    QTimer _refreshTimer;
+    QFormLayout *_figures;
+    QLabel *_spread;
+    QLabel *_decoders;
+    QLabel *_depot;
+    QLabel *_packed;
+    QLabel *_diskCache;
+    QLabel *_extraction;
+    QLabel *_decode;
+    QLabel *_wrongSize;
+    QLabel *_frames;
+    QLabel *_latency;
+};
+
+#endif
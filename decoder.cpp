@@ -1,5 +1,8 @@
 #include "decoder.h"
 
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QProcess>
 #include <QTextCodec>
@@ -11,11 +14,20 @@
 #include "imagesource.h"
 #include "indexer.h"
 #include "strategist.h"
+#include "trace.h"
 
 Decoder::Decoder(QObject *parent)
     : QObject(parent)
 {
     _cancelled = false;
+    _bytes = 0;
+    _extractionMs = -1.0;
+    _decodeMs = 0.0;
+    _traceId = -1;
+    _extracter = NULL;
+    _imageSource = NULL;
+    _file = NULL;
+    _buffer = NULL;
 }
 
 Decoder::~Decoder()
@@ -29,6 +41,16 @@ Decoder::~Decoder()
 
     delete _imageSource;
     delete _extracter;
+
+    // (The buffer reads from the file's mapping)
+    delete _buffer;
+    delete _file;
+
+    // End the page's span, if it was deleted before finishing
+    if (_traceId != -1)
+    {
+        Trace::asyncEnd("page", _traceId);
+    }
     //debug()<<"~Decoder()";
 }
 
@@ -37,12 +59,37 @@ int Decoder::pageNum()
     return _pageNum;
 }
 
+qint64 Decoder::bytes() const
+{
+    return _bytes;
+}
+
+/**
+ * If the extracter hasn't exited yet, all its data was at least read by the
+ * time decoding finished.
+ */
+double Decoder::extractionMs() const
+{
+    return _extractionMs >= 0.0 ? _extractionMs : double(_time.elapsed());
+}
+
+double Decoder::decodeMs() const
+{
+    return _decodeMs;
+}
+
 void Decoder::cancel()
 {
     _cancelled = true;
 
     debug()<<"Cancelling"<<_pageNum;
 
+    // A mapped file is read without waiting, so there's nothing to stop
+    if (_extracter == NULL)
+    {
+        return;
+    }
+
     // Prevent image decoding
     _imageSource->close();
 
@@ -64,79 +111,71 @@ void Decoder::cancel()
     }
 }
 
-/**
- * @todo Use correct path on Windows to find 7z
- */
-QStringList Decoder::chooseExtracterArguments(
+void Decoder::startExtracter(
     const Archive &archive,
     const QByteArray &pageFilename)
 {
-    QStringList args;
+    QString command = archive.programPath();
+    QStringList args = archive.extractionArguments(pageFilename, _temporaryFile);
+    _extracter = new QProcess();
+    connect(_extracter, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(extracterFinished()));
 
-    switch (archive.type())
+    // Note when the first bytes arrive
+    if (Trace::isEnabled())
     {
-        case Archive::SevenZip:
-            args<<"e"<<"-so";
-#ifdef Q_OS_WIN32
-            // Specify the list file encoding on Windows
-            args<<"-scsDOS";
-#endif
-            break;
-        case Archive::Tar:
-            args<<"-xOf";
-            break;
-        case Archive::Zip:
-            args<<"-p";
-            break;
-        case Archive::Rar:
-            args<<"p"<<"-ierr";
-            // Note: With "-ierr", the header info is put into stderr (and not into the image data)
-            break;
-        default:
-            Q_ASSERT(false);
+        connect(_extracter, SIGNAL(readyReadStandardOutput()), SLOT(extracterFirstData()));
     }
 
-    // Pass in the archive file name
-    args<<archive.filename();
-
-    // Pass in the name of the compressed file
-    if (archive.type() == Archive::SevenZip)
-    {
-        _temporaryFile.open();
-        _temporaryFile.write(pageFilename);
-        _temporaryFile.write("\n");
-        _temporaryFile.flush();
-
-        args<<("-i@" + _temporaryFile.fileName());
-    }
-    else
-    {
-        args<<QString::fromLocal8Bit(pageFilename);
-    }
+    TraceScope scope("spawn", _pageNum);
+    _extracter->start(command, args);
+    //debug()<<"Starting"<<command<<args;
+}
 
-    return args;
+void Decoder::extracterFirstData()
+{
+    Trace::instant("first byte", _pageNum);
+    disconnect(_extracter, SIGNAL(readyReadStandardOutput()), this, SLOT(extracterFirstData()));
 }
 
-void Decoder::startExtracter(
-    const Archive &archive,
-    const QByteArray &pageFilename)
+void Decoder::extracterFinished()
 {
-    QString command = archive.programPath();
-    QStringList args = chooseExtracterArguments(archive, pageFilename);
-    _extracter = new QProcess();
-    _extracter->start(command, args);
-    //debug()<<"Starting"<<command<<args;
+    _extractionMs = double(_time.elapsed());
 }
 
-void Decoder::makeImageSource(int uncompressedSize)
+void Decoder::makeImageSource(qint64 uncompressedSize)
 {
     // Set up blocking-IO cancellable proxy
     _imageSource = new ImageSource(_extracter, uncompressedSize);
 }
 
-void Decoder::setUpImageReader(const QByteArray &pageFilename)
+/**
+ * Images in a folder are read straight from a mapping of the file, with no
+ * process to start and no pipe to wait on.
+ */
+void Decoder::mapFile(
+    const Archive &archive,
+    const QByteArray &pageFilename)
+{
+    TraceScope scope("map", _pageNum);
+
+    _file = new QFile(QDir(archive.filename()).filePath(QFile::decodeName(pageFilename)));
+    _file->open(QIODevice::ReadOnly);
+    _extractionMs = 0.0;
+
+    const uchar *data = _file->size() > 0 ? _file->map(0, _file->size()) : NULL;
+
+    // Read it normally if it can't be mapped
+    if (data != NULL)
+    {
+        _buffer = new QBuffer();
+        _buffer->setData(QByteArray::fromRawData(reinterpret_cast<const char *>(data), _file->size()));
+        _buffer->open(QIODevice::ReadOnly);
+    }
+}
+
+void Decoder::setUpImageReader(const QByteArray &pageFilename, QIODevice *device)
 {
-    _imageReader.setDevice(_imageSource);
+    _imageReader.setDevice(device);
 
     _imageReader.setFormat(
         QFileInfo(pageFilename)
@@ -161,13 +200,30 @@ void Decoder::startMeasuring()
     connect(measureWatcher, SIGNAL(finished()), SLOT(measureFinished()));
 
     // Start the future
-    _measureFuture = QtConcurrent::run(
-        &_imageReader, &QImageReader::size);
+    _measureFuture = QtConcurrent::run(this, &Decoder::measure);
 
     // Subscribe to the future finishing
     measureWatcher->setFuture(_measureFuture);
 }
 
+QSize Decoder::measure()
+{
+    TraceScope scope("measure", _pageNum);
+    return _imageReader.size();
+}
+
+QImage Decoder::read()
+{
+    TraceScope scope("decode", _pageNum);
+    QElapsedTimer decodeTime;
+    decodeTime.start();
+
+    QImage image = _imageReader.read();
+    _decodeMs = double(decodeTime.nsecsElapsed()) / 1000000.0;
+
+    return image;
+}
+
 void Decoder::measureFinished()
 {
     if (!_cancelled)
@@ -186,6 +242,8 @@ void Decoder::measureFinished()
     else
     {
         // Cancelled
+        Trace::asyncEnd("page", _traceId);
+        _traceId = -1;
         emit cancelled(this);
     }
 }
@@ -202,8 +260,7 @@ void Decoder::startDecoding()
     connect(decodeWatcher, SIGNAL(finished()), SLOT(decodeFinished()));
 
     // Start the future
-    _decodeFuture = QtConcurrent::run(
-        &_imageReader, &QImageReader::read);
+    _decodeFuture = QtConcurrent::run(this, &Decoder::read);
 
     // Subscribe to the future finishing
     decodeWatcher->setFuture(_decodeFuture);
@@ -213,6 +270,9 @@ void Decoder::decodeFinished()
 {
     //debug()<<"Decoded"<<_pageNum<<"--"<<_time.elapsed()<<"ms";
 
+    Trace::asyncEnd("page", _traceId);
+    _traceId = -1;
+
     // Give notification
     if (!_cancelled)
     {
@@ -220,10 +280,8 @@ void Decoder::decodeFinished()
         QImage image = _decodeFuture.result();
         Q_ASSERT(!image.isNull());
 
-        // Conver the image to a pixmap
-        QPixmap pixmap(QPixmap::fromImage(image));
-
-        emit done(this, _pageNum, pixmap);
+        // Pixmap conversion is left to the sprite, one tile at a time
+        emit done(this, _pageNum, image);
     }
     else
     {
@@ -232,8 +290,10 @@ void Decoder::decodeFinished()
     }
 }
 
+/**
+ * The page comes from the book itself, or from an archive inside it.
+ */
 void Decoder::decode(
-    const Archive &archive,
     const Indexer &indexer,
     Strategist &strategist,
     int pageNum)
@@ -241,13 +301,26 @@ void Decoder::decode(
     _strategist = &strategist;
     _pageNum = pageNum;
     _time.start();
+    _traceId = Trace::newId();
+    Trace::asyncBegin("page", _traceId);
 
+    const Archive &archive = indexer.pageArchive(_pageNum);
     QByteArray pageFilename = indexer.pageName(_pageNum); 
-    int uncompressedSize = indexer.uncompressedSize(_pageNum);
+    qint64 uncompressedSize = indexer.uncompressedSize(_pageNum);
+    _bytes = uncompressedSize;
 
-    startExtracter(archive, pageFilename);
+    if (archive.type() == Archive::Directory)
+    {
+        mapFile(archive, pageFilename);
 
-    makeImageSource(uncompressedSize);
+        setUpImageReader(pageFilename, _buffer != NULL ? static_cast<QIODevice *>(_buffer) : _file);
+    }
+    else
+    {
+        startExtracter(archive, pageFilename);
 
-    setUpImageReader(pageFilename);
+        makeImageSource(uncompressedSize);
+
+        setUpImageReader(pageFilename, _imageSource);
+    }
 }
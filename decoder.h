@@ -6,11 +6,12 @@
 #include <QFutureWatcher>
 #include <QImage>
 #include <QImageReader>
-#include <QPixmap>
 #include <QStringList>
 #include <QTemporaryFile>
 #include <QTime>
 
+class QBuffer;
+class QFile;
 class QProcess;
 
 class Archive;
@@ -27,34 +28,41 @@ public:
     ~Decoder();
 
     void decode(
-        const Archive &archive,
         const Indexer &indexer,
         Strategist &strategist,
         int pageNum);
 
     int pageNum();
 
+    qint64 bytes() const;
+    double extractionMs() const;
+    double decodeMs() const;
+
     void cancel();
 
 signals:
-    void done(Decoder *decoder, int pageNum, QPixmap pixmap);
+    void done(Decoder *decoder, int pageNum, QImage image);
     void cancelled(Decoder *decoder);
 
 private slots:
+    void extracterFirstData();
+    void extracterFinished();
     void measureFinished();
     void decodeFinished();
 
 private:
-    QStringList chooseExtracterArguments(
+    void startExtracter(
         const Archive &archive,
         const QByteArray &pageFilename);
-    void startExtracter(
+    void makeImageSource(qint64 uncompressedSize);
+    void mapFile(
         const Archive &archive,
         const QByteArray &pageFilename);
-    void makeImageSource(int uncompressedSize);
-    void setUpImageReader(const QByteArray &pageFilename);
+    void setUpImageReader(const QByteArray &pageFilename, QIODevice *device);
     void startMeasuring();
     void startDecoding();
+    QSize measure();
+    QImage read();
 
 private:
     static const int KILL_WAIT = 50;
@@ -67,9 +75,15 @@ private:
     QTime _time;
 
     int _pageNum;
+    qint64 _bytes;
+    double _extractionMs;
+    double _decodeMs;
+    qint64 _traceId;
 
     QProcess *_extracter;
     ImageSource *_imageSource;
+    QFile *_file;
+    QBuffer *_buffer;
     QImageReader _imageReader;
 
     QTemporaryFile _temporaryFile;
@@ -0,0 +1,390 @@
+#include "depot.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrentRun>
+
+#include "debug.h"
+#include "trace.h"
+
+const int Depot::LEVELS = 3;
+const int Depot::MIN_LEVEL_SIZE = 64;
+const qint64 Depot::MAX_BYTES = Q_INT64_C(192) * 1024 * 1024;
+const qint64 Depot::MAX_PACKED_BYTES = Q_INT64_C(64) * 1024 * 1024;
+const qint64 Depot::MAX_PACKING_BYTES = Q_INT64_C(32) * 1024 * 1024;
+const int Depot::STATS_UNPACKS = 100;
+
+Depot::Depot(QObject *parent)
+    : QObject(parent), _unpackTimes(STATS_UNPACKS)
+{
+    _bytesUsed = 0;
+    _packingBytes = 0;
+    _packedBytes = 0;
+    _packedUnpackedBytes = 0;
+    _packedHits = 0;
+
+    _hits = 0;
+    _scaledHits = 0;
+    _misses = 0;
+}
+
+Depot::~Depot()
+{
+}
+
+void Depot::reset()
+{
+    foreach (int index, _levelling.keys())
+    {
+        stopLevels(index);
+    }
+
+    _entries.clear();
+    _recent.clear();
+    _bytesUsed = 0;
+
+    // Packing that's still running is left to finish, and ignored
+    foreach (const Packing &packing, _packing)
+    {
+        packing.watcher->disconnect(this);
+        packing.watcher->deleteLater();
+    }
+    _packing.clear();
+    _packingBytes = 0;
+
+    _packed.clear();
+    _packedRecent.clear();
+    _packedBytes = 0;
+    _packedUnpackedBytes = 0;
+}
+
+void Depot::store(int index, const QImage &image)
+{
+    Q_ASSERT(!image.isNull());
+
+    // Replace any older decode
+    if (_entries.contains(index))
+    {
+        _bytesUsed -= _entries[index].bytes;
+    }
+    stopLevels(index);
+    forget(index);
+
+    Entry entry;
+    entry.levels<<image;
+    entry.bytes = image.byteCount();
+
+    _entries[index] = entry;
+    _bytesUsed += entry.bytes;
+    touch(index);
+
+    // The rest of the pyramid comes later
+    QFutureWatcher<QList<QImage> > *watcher = new QFutureWatcher<QList<QImage> >(this);
+    connect(watcher, SIGNAL(finished()), SLOT(levelsFinished()));
+    _levelling[index] = watcher;
+    watcher->setFuture(QtConcurrent::run(&Depot::makeLevels, image));
+
+    // Stay within the budget
+    decache();
+}
+
+/**
+ * Choose the smallest level that still covers the requested size, or the
+ * biggest level if none do. The result is exact when the page was decoded at
+ * that size.
+ */
+QImage Depot::level(int index, const QSize &size)
+{
+    if (!_entries.contains(index) && !unpack(index))
+    {
+        _misses++;
+        return QImage();
+    }
+
+    touch(index);
+
+    const QList<QImage> &levels = _entries[index].levels;
+    int chosen = 0;
+
+    for (int i = 1; i < levels.size(); i++)
+    {
+        if (levels[i].width() >= size.width() && levels[i].height() >= size.height())
+        {
+            chosen = i;
+        }
+    }
+
+    // Count how useful the lookup was
+    if (levels[chosen].size() == size)
+    {
+        _hits++;
+    }
+    else
+    {
+        _scaledHits++;
+    }
+
+    return levels[chosen];
+}
+
+qint64 Depot::bytesUsed() const
+{
+    return _bytesUsed;
+}
+
+/**
+ * Whether the page is held in either tier (or is still being packed).
+ */
+bool Depot::contains(int index) const
+{
+    return _entries.contains(index) || _packing.contains(index) || _packed.contains(index);
+}
+
+int Depot::pagesHeld() const
+{
+    return _entries.size();
+}
+
+int Depot::hits() const
+{
+    return _hits;
+}
+
+int Depot::scaledHits() const
+{
+    return _scaledHits;
+}
+
+int Depot::misses() const
+{
+    return _misses;
+}
+
+void Depot::touch(int index)
+{
+    // Most recent at the back
+    _recent.removeOne(index);
+    _recent<<index;
+}
+
+/**
+ * Runs on the thread pool. The smaller levels are only for previews, so
+ * they're kept cheap to make.
+ */
+QList<QImage> Depot::makeLevels(QImage image)
+{
+    TraceScope scope("levels");
+    QList<QImage> levels;
+    QImage last = image;
+
+    while (levels.size() + 1 < LEVELS
+        && last.width() / 2 >= MIN_LEVEL_SIZE
+        && last.height() / 2 >= MIN_LEVEL_SIZE)
+    {
+        last = last.scaled(last.size() / 2, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        levels<<last;
+    }
+
+    return levels;
+}
+
+void Depot::levelsFinished()
+{
+    // Add the levels of every page that's done
+    QMap<int, QFutureWatcher<QList<QImage> > *>::iterator i = _levelling.begin();
+
+    while (i != _levelling.end())
+    {
+        if (!(*i)->isFinished())
+        {
+            ++i;
+            continue;
+        }
+
+        QList<QImage> levels = (*i)->result();
+        (*i)->deleteLater();
+
+        // (The page is still held, as dropping it stops its levels)
+        Entry &entry = _entries[i.key()];
+
+        foreach (const QImage &level, levels)
+        {
+            entry.levels<<level;
+            entry.bytes += level.byteCount();
+            _bytesUsed += level.byteCount();
+        }
+
+        i = _levelling.erase(i);
+    }
+
+    decache();
+}
+
+/**
+ * Forget the levels being made for a page.
+ */
+void Depot::stopLevels(int index)
+{
+    if (_levelling.contains(index))
+    {
+        QFutureWatcher<QList<QImage> > *watcher = _levelling.take(index);
+        watcher->disconnect(this);
+        watcher->deleteLater();
+    }
+}
+
+void Depot::decache()
+{
+    // Always keep the most recent page
+    while (_bytesUsed > MAX_BYTES && _recent.size() > 1)
+    {
+        int index = _recent.takeFirst();
+        _bytesUsed -= _entries[index].bytes;
+        stopLevels(index);
+
+        // Move the full size level to the packed tier, unless too many are
+        // still waiting to be packed
+        const QImage &image = _entries[index].levels.front();
+
+        if (_packingBytes + image.byteCount() <= MAX_PACKING_BYTES)
+        {
+            pack(index, image);
+        }
+        _entries.remove(index);
+    }
+}
+
+void Depot::pack(int index, const QImage &image)
+{
+    Packing packing;
+    packing.image = image;
+    packing.watcher = new QFutureWatcher<PackedImage>(this);
+    connect(packing.watcher, SIGNAL(finished()), SLOT(packingFinished()));
+
+    _packing[index] = packing;
+    _packingBytes += image.byteCount();
+    packing.watcher->setFuture(QtConcurrent::run(&PackedImage::pack, image));
+}
+
+void Depot::packingFinished()
+{
+    // Collect every page that's done packing
+    QMap<int, Packing>::iterator i = _packing.begin();
+
+    while (i != _packing.end())
+    {
+        if (!i->watcher->isFinished())
+        {
+            ++i;
+            continue;
+        }
+
+        PackedImage packed = i->watcher->result();
+        i->watcher->deleteLater();
+        _packingBytes -= i->image.byteCount();
+
+        _packed[i.key()] = packed;
+        _packedBytes += packed.packedBytes();
+        _packedUnpackedBytes += packed.unpackedBytes();
+        _packedRecent<<i.key();
+
+        i = _packing.erase(i);
+    }
+
+    decachePacked();
+}
+
+/**
+ * Bring a page back from the packed tier (or from packing), returning false
+ * if it isn't there.
+ */
+bool Depot::unpack(int index)
+{
+    QImage image;
+
+    if (_packing.contains(index))
+    {
+        // Still packing, so the original is at hand
+        image = _packing[index].image;
+    }
+    else if (_packed.contains(index))
+    {
+        TraceScope scope("unpack", index);
+        QElapsedTimer unpackTime;
+        unpackTime.start();
+
+        image = _packed[index].unpack();
+
+        _unpackTimes.addSample(double(unpackTime.nsecsElapsed()) / 1000000.0);
+    }
+    else
+    {
+        return false;
+    }
+
+    _packedHits++;
+    store(index, image);
+    return true;
+}
+
+/**
+ * Drop a page from the packed tier.
+ */
+void Depot::forget(int index)
+{
+    if (_packing.contains(index))
+    {
+        Packing packing = _packing.take(index);
+        _packingBytes -= packing.image.byteCount();
+        packing.watcher->disconnect(this);
+        packing.watcher->deleteLater();
+    }
+
+    if (_packed.contains(index))
+    {
+        _packedBytes -= _packed[index].packedBytes();
+        _packedUnpackedBytes -= _packed[index].unpackedBytes();
+        _packed.remove(index);
+        _packedRecent.removeOne(index);
+    }
+}
+
+void Depot::decachePacked()
+{
+    while (_packedBytes > MAX_PACKED_BYTES && !_packedRecent.isEmpty())
+    {
+        forget(_packedRecent.front());
+    }
+}
+
+int Depot::packedHits() const
+{
+    return _packedHits;
+}
+
+int Depot::pagesPacked() const
+{
+    return _packed.size();
+}
+
+qint64 Depot::packedBytesUsed() const
+{
+    return _packedBytes;
+}
+
+/**
+ * Of the pages in the packed tier, as unpacked bytes per packed byte.
+ */
+double Depot::compressionRatio() const
+{
+    if (_packedBytes == 0)
+    {
+        return 0.0;
+    }
+
+    return double(_packedUnpackedBytes) / double(_packedBytes);
+}
+
+const Distribution &Depot::unpackTimes() const
+{
+    return _unpackTimes;
+}
@@ -0,0 +1,111 @@
+#ifndef DEPOT_H
+#define DEPOT_H
+
+#include <QObject>
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QList>
+#include <QMap>
+
+#include "distribution.h"
+#include "packedimage.h"
+
+/**
+ * @brief Stores decoded pages for later use.
+ *
+ * Each page is kept as a small pyramid (the decoded size, then halves of it,
+ * made on the thread pool), so a page that was already seen can be shown
+ * right away at any layout size, scaled from the closest level, while a
+ * properly sized decode runs. Pages are dropped least recently used first
+ * when over the memory budget.
+ *
+ * Dropped pages move to a second tier, packed (on the thread pool) to a
+ * fraction of their size, and are unpacked again if they're needed. Pages
+ * leave that tier least recently used first, too. The pages still waiting
+ * to be packed have a budget of their own, and pages past it are dropped
+ * outright.
+ */
+class Depot : public QObject
+{
+    Q_OBJECT
+
+public:
+    Depot(QObject *parent = NULL);
+    ~Depot();
+
+    void reset();
+
+    void store(int index, const QImage &image);
+    QImage level(int index, const QSize &size);
+    bool contains(int index) const;
+
+    qint64 bytesUsed() const;
+    int pagesHeld() const;
+
+    int hits() const;
+    int scaledHits() const;
+    int misses() const;
+
+    int packedHits() const;
+    int pagesPacked() const;
+    qint64 packedBytesUsed() const;
+    double compressionRatio() const;
+    const Distribution &unpackTimes() const;
+
+private slots:
+    void levelsFinished();
+    void packingFinished();
+
+private:
+    struct Entry
+    {
+        QList<QImage> levels;
+        qint64 bytes;
+    };
+
+    struct Packing
+    {
+        QImage image;
+        QFutureWatcher<PackedImage> *watcher;
+    };
+
+private:
+    void touch(int index);
+    static QList<QImage> makeLevels(QImage image);
+    void stopLevels(int index);
+    void decache();
+    void pack(int index, const QImage &image);
+    bool unpack(int index);
+    void forget(int index);
+    void decachePacked();
+
+private:
+    static const int LEVELS;
+    static const int MIN_LEVEL_SIZE;
+    static const qint64 MAX_BYTES;
+    static const qint64 MAX_PACKED_BYTES;
+    static const qint64 MAX_PACKING_BYTES;
+    static const int STATS_UNPACKS;
+
+private:
+    QMap<int, Entry> _entries;
+    QList<int> _recent;
+    qint64 _bytesUsed;
+    QMap<int, QFutureWatcher<QList<QImage> > *> _levelling;
+
+    int _hits;
+    int _scaledHits;
+    int _misses;
+
+    QMap<int, Packing> _packing;
+    qint64 _packingBytes;
+    QMap<int, PackedImage> _packed;
+    QList<int> _packedRecent;
+    qint64 _packedBytes;
+    qint64 _packedUnpackedBytes;
+    int _packedHits;
+    Distribution _unpackTimes;
+};
+
+#endif
@@ -0,0 +1,409 @@
+#include "diskcache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+#include <string.h>
+
+#include "archive.h"
+#include "debug.h"
+#include "trace.h"
+
+using std::sort;
+
+const char DiskCache::MAGIC[4] = {'Y', 'K', 'P', 'G'};
+const qint32 DiskCache::VERSION = 1;
+const qint64 DiskCache::MAX_BYTES = Q_INT64_C(1024) * 1024 * 1024;
+
+namespace
+{
+    struct CachedFile
+    {
+        QString path;
+        QDateTime used;
+        qint64 size;
+
+        bool operator<(const CachedFile &other) const
+        {
+            return used < other.used;
+        }
+    };
+}
+
+DiskCache::DiskCache(QObject *parent)
+    : QObject(parent)
+{
+    _hits = 0;
+    _misses = 0;
+    _bytesUsed = 0;
+
+    // Make the cache folder
+    _root = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    _root.mkpath("pages");
+    _root.cd("pages");
+
+    // Tally up what's already there
+    QDirIterator files(_root.path(), cachedFiles(), QDir::Files, QDirIterator::Subdirectories);
+    while (files.hasNext())
+    {
+        files.next();
+        _bytesUsed += files.fileInfo().size();
+    }
+}
+
+DiskCache::~DiskCache()
+{
+    // Let the writes finish
+    foreach (QFuture<void> write, _writes)
+    {
+        write.waitForFinished();
+    }
+}
+
+/**
+ * Returns a null image if the page isn't cached at exactly that size.
+ */
+QImage DiskCache::load(const QByteArray &identity, int index, const QSize &size)
+{
+    TraceScope scope("disk cache", index);
+
+    QFile *file = new QFile(pagePath(identity, index, size));
+
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header)))
+    {
+        delete file;
+        _misses++;
+        return QImage();
+    }
+
+    // Check the header
+    Header header;
+    bool ok = (file->read(reinterpret_cast<char *>(&header), sizeof(Header)) == sizeof(Header))
+        && memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+        && header.version == VERSION
+        && QSize(header.width, header.height) == size
+        && file->size() == qint64(sizeof(Header)) + qint64(header.bytesPerLine) * header.height;
+
+    // (Read-only, so the image copies it if it's ever changed)
+    const uchar *data = ok ? file->map(0, file->size()) : NULL;
+
+    if (data == NULL)
+    {
+        delete file;
+        _misses++;
+        return QImage();
+    }
+
+    // Mark it as recently used
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    // The image owns the mapping (and unmaps it when the last copy goes)
+    _hits++;
+    return QImage(data + sizeof(Header), header.width, header.height, header.bytesPerLine,
+        QImage::Format(header.format), &DiskCache::unmap, file);
+}
+
+void DiskCache::store(const QByteArray &identity, int index, const QImage &image)
+{
+    Q_ASSERT(!image.isNull());
+
+    // Only direct colour formats can be mapped back as they are
+    QImage page = image;
+    if (page.format() == QImage::Format_Indexed8 || page.format() == QImage::Format_Mono
+        || page.format() == QImage::Format_MonoLSB)
+    {
+        page = page.convertToFormat(page.hasAlphaChannel() ?
+            QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    }
+
+    _root.mkpath(QString::fromLatin1(identity));
+
+    // Forget the writes that are done
+    for (int i = _writes.size() - 1; i >= 0; i--)
+    {
+        if (_writes[i].isFinished())
+        {
+            _writes.removeAt(i);
+        }
+    }
+
+    _writes<<QtConcurrent::run(this, &DiskCache::write, pagePath(identity, index, page.size()), page);
+}
+
+QMap<int, QSize> DiskCache::fullSizes(const QByteArray &identity)
+{
+    QMap<int, QSize> sizes;
+    QFile file(sizesPath(identity));
+
+    if (file.open(QIODevice::ReadOnly))
+    {
+        QDataStream in(&file);
+
+        while (!in.atEnd())
+        {
+            qint32 index;
+            QSize size;
+            in>>index>>size;
+
+            if (in.status() != QDataStream::Ok)
+            {
+                break;
+            }
+
+            sizes[index] = size;
+        }
+    }
+
+    return sizes;
+}
+
+/**
+ * Sizes are appended as they're measured; later ones win when read.
+ */
+void DiskCache::storeFullSize(const QByteArray &identity, int index, const QSize &size)
+{
+    _root.mkpath(QString::fromLatin1(identity));
+
+    QFile file(sizesPath(identity));
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        QDataStream out(&file);
+        out<<qint32(index)<<size;
+    }
+}
+
+/**
+ * The archive's saved listing, or an empty array if it hasn't been listed.
+ */
+QByteArray DiskCache::listing(const QByteArray &identity)
+{
+    QFile file(listingPath(identity));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+
+    return file.readAll();
+}
+
+void DiskCache::storeListing(const QByteArray &identity, const QByteArray &listing)
+{
+    _root.mkpath(QString::fromLatin1(identity));
+
+    QSaveFile file(listingPath(identity));
+
+    if (file.open(QIODevice::WriteOnly))
+    {
+        file.write(listing);
+        file.commit();
+    }
+}
+
+int DiskCache::hits() const
+{
+    return _hits;
+}
+
+int DiskCache::misses() const
+{
+    return _misses;
+}
+
+QString DiskCache::pagePath(const QByteArray &identity, int index, const QSize &size) const
+{
+    return _root.filePath(QString("%1/%2-%3x%4.page")
+        .arg(QString::fromLatin1(identity))
+        .arg(index)
+        .arg(size.width())
+        .arg(size.height()));
+}
+
+QString DiskCache::sizesPath(const QByteArray &identity) const
+{
+    return _root.filePath(QString("%1/sizes").arg(QString::fromLatin1(identity)));
+}
+
+/**
+ * Where a page's thumbnail is kept (as a JPEG, read and written by the
+ * thumbnailer).
+ */
+QString DiskCache::thumbnailPath(const QByteArray &identity, int index)
+{
+    _root.mkpath(QString("%1/thumbnails").arg(QString::fromLatin1(identity)));
+
+    return _root.filePath(QString("%1/thumbnails/%2.jpg")
+        .arg(QString::fromLatin1(identity))
+        .arg(index));
+}
+
+/**
+ * Where the archives inside a book are extracted to (by its indexer, which
+ * reports them through added()).
+ */
+QString DiskCache::archiveFolder(const QByteArray &identity) const
+{
+    return _root.filePath(QString("%1/archives").arg(QString::fromLatin1(identity)));
+}
+
+/**
+ * The book being read, whose inner archives are never evicted (its pages
+ * are read from them).
+ */
+void DiskCache::setReading(const QByteArray &identity)
+{
+    QMutexLocker locker(&_usageLock);
+    _readingFolder = archiveFolder(identity) + '/';
+}
+
+QString DiskCache::listingPath(const QByteArray &identity) const
+{
+    return _root.filePath(QString("%1/listing").arg(QString::fromLatin1(identity)));
+}
+
+/**
+ * Runs on the thread pool. The page appears all at once, or not at all.
+ */
+void DiskCache::write(QString path, QImage image)
+{
+    TraceScope scope("disk write");
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.width = image.width();
+    header.height = image.height();
+    header.bytesPerLine = image.bytesPerLine();
+    header.format = image.format();
+    header.reserved[0] = 0;
+    header.reserved[1] = 0;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char *>(image.constBits()), qint64(image.bytesPerLine()) * image.height());
+
+    if (!file.commit())
+    {
+        debug()<<"Couldn't cache"<<path;
+        return;
+    }
+
+    // Make room if needed
+    bool over;
+    {
+        QMutexLocker locker(&_usageLock);
+        _bytesUsed += qint64(sizeof(Header)) + qint64(image.bytesPerLine()) * image.height();
+        over = _bytesUsed > MAX_BYTES;
+    }
+
+    if (over)
+    {
+        evict();
+    }
+}
+
+/**
+ * Count a file written into the cache folder by someone else (a thumbnail,
+ * say), making room if needed. Called on the GUI thread.
+ */
+void DiskCache::added(qint64 bytes)
+{
+    bool over;
+    {
+        QMutexLocker locker(&_usageLock);
+        _bytesUsed += bytes;
+        over = _bytesUsed > MAX_BYTES;
+    }
+
+    if (over)
+    {
+        _writes<<QtConcurrent::run(this, &DiskCache::evict);
+    }
+}
+
+/**
+ * Removes the least recently used files until under three quarters of the
+ * cap, so eviction doesn't run on every write.
+ */
+void DiskCache::evict()
+{
+    QMutexLocker locker(&_usageLock);
+
+    if (_bytesUsed <= MAX_BYTES)
+    {
+        return;
+    }
+
+    // Find everything that counts
+    QList<CachedFile> files;
+    qint64 total = 0;
+
+    QDirIterator iterator(_root.path(), cachedFiles(), QDir::Files, QDirIterator::Subdirectories);
+    while (iterator.hasNext())
+    {
+        iterator.next();
+
+        CachedFile file;
+        file.path = iterator.filePath();
+        file.used = iterator.fileInfo().lastModified();
+        file.size = iterator.fileInfo().size();
+        files<<file;
+
+        total += file.size;
+
+        // (Counted, but kept)
+        if (!_readingFolder.isEmpty() && file.path.startsWith(_readingFolder))
+        {
+            files.removeLast();
+        }
+    }
+
+    // Oldest first
+    sort(files.begin(), files.end());
+
+    for (int i = 0; i < files.size() && total > MAX_BYTES / 4 * 3; i++)
+    {
+        if (QFile::remove(files[i].path))
+        {
+            total -= files[i].size;
+        }
+    }
+
+    _bytesUsed = total;
+}
+
+/**
+ * The files that count against the cap: pages, thumbnails, and inner
+ * archives.
+ */
+QStringList DiskCache::cachedFiles()
+{
+    QStringList filters;
+    filters<<"*.page"<<"*.jpg";
+
+    for (int i = 0; *Archive::EXTENSIONS[i].ext != '\0'; i++)
+    {
+        filters<<QString("*") + Archive::EXTENSIONS[i].ext;
+    }
+
+    return filters;
+}
+
+void DiskCache::unmap(void *file)
+{
+    // Closing the file unmaps it
+    delete static_cast<QFile *>(file);
+}
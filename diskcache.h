@@ -0,0 +1,91 @@
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include <QObject>
+
+#include <QDir>
+#include <QFuture>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+
+/**
+ * @brief Keeps decoded pages on disk, to be mapped straight back into memory.
+ *
+ * Pages are stored raw (a small header, then the scanlines) under the user's
+ * cache directory, one folder per archive identity, keyed by page index and
+ * size. Loading maps the file, so a hit costs no extraction or decoding. The
+ * full page sizes measured for each book are kept too, along with its listing,
+ * so a book can be laid out right away when it's opened again.
+ *
+ * Writes happen on the thread pool. When over the size cap, the least
+ * recently used pages, thumbnails and extracted inner archives are removed
+ * (hits touch the file's modification time), except the archives of the
+ * book being read.
+ */
+class DiskCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    DiskCache(QObject *parent = NULL);
+    ~DiskCache();
+
+    QImage load(const QByteArray &identity, int index, const QSize &size);
+    void store(const QByteArray &identity, int index, const QImage &image);
+
+    QMap<int, QSize> fullSizes(const QByteArray &identity);
+    void storeFullSize(const QByteArray &identity, int index, const QSize &size);
+
+    QByteArray listing(const QByteArray &identity);
+    void storeListing(const QByteArray &identity, const QByteArray &listing);
+
+    QString thumbnailPath(const QByteArray &identity, int index);
+    QString archiveFolder(const QByteArray &identity) const;
+    void setReading(const QByteArray &identity);
+
+    int hits() const;
+    int misses() const;
+
+public slots:
+    void added(qint64 bytes);
+
+private:
+    struct Header
+    {
+        char magic[4];
+        qint32 version;
+        qint32 width;
+        qint32 height;
+        qint32 bytesPerLine;
+        qint32 format;
+        qint32 reserved[2];
+    };
+
+private:
+    QString pagePath(const QByteArray &identity, int index, const QSize &size) const;
+    QString sizesPath(const QByteArray &identity) const;
+    QString listingPath(const QByteArray &identity) const;
+    void write(QString path, QImage image);
+    void evict();
+    static void unmap(void *file);
+    static QStringList cachedFiles();
+
+private:
+    static const char MAGIC[4];
+    static const qint32 VERSION;
+    static const qint64 MAX_BYTES;
+
+private:
+    QDir _root;
+    int _hits;
+    int _misses;
+
+    QList<QFuture<void> > _writes;
+
+    QMutex _usageLock;
+    qint64 _bytesUsed;
+    QString _readingFolder;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "distribution.h"
+
+#include <algorithm>
+
+#include <QtGlobal>
+
+using std::nth_element;
+
+Distribution::Distribution(int capacity)
+{
+    Q_ASSERT(capacity > 0);
+    _capacity = capacity;
+    _next = 0;
+}
+
+Distribution::~Distribution()
+{
+}
+
+void Distribution::addSample(double value)
+{
+    // Fill up, then overwrite the oldest
+    if (int(_samples.size()) < _capacity)
+    {
+        _samples.push_back(value);
+    }
+    else
+    {
+        _samples[_next] = value;
+    }
+
+    _next = (_next + 1) % _capacity;
+}
+
+void Distribution::clear()
+{
+    _samples.clear();
+    _next = 0;
+}
+
+int Distribution::count() const
+{
+    return _samples.size();
+}
+
+double Distribution::mean() const
+{
+    if (_samples.empty())
+    {
+        return 0.0;
+    }
+
+    double total = 0.0;
+
+    for (unsigned int i = 0; i < _samples.size(); i++)
+    {
+        total += _samples[i];
+    }
+
+    return total / double(_samples.size());
+}
+
+/**
+ * Nearest-rank percentile, with the fraction between 0 and 1.
+ */
+double Distribution::percentile(double fraction) const
+{
+    if (_samples.empty())
+    {
+        return 0.0;
+    }
+
+    vector<double> sorted(_samples);
+    int rank = qBound(0, int(fraction * double(sorted.size())), int(sorted.size()) - 1);
+    nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+
+    return sorted[rank];
+}
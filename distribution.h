@@ -0,0 +1,32 @@
+#ifndef DISTRIBUTION_H
+#define DISTRIBUTION_H
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * @brief The most recent samples of a measurement, for percentiles.
+ *
+ * Keeps a fixed number of samples, overwriting the oldest.
+ */
+class Distribution
+{
+public:
+    Distribution(int capacity);
+    ~Distribution();
+
+    void addSample(double value);
+    void clear();
+
+    int count() const;
+    double mean() const;
+    double percentile(double fraction) const;
+
+private:
+    vector<double> _samples;
+    int _capacity;
+    int _next;
+};
+
+#endif
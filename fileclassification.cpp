@@ -1,5 +1,7 @@
 #include "fileclassification.h"
 
+#include "archive.h"
+
 /**
  * @todo Use QImageReader::supportedImageFormats()
  */
@@ -31,6 +33,19 @@ bool FileClassification::isImageFile(const QByteArray& filename)
     return false;
 }
 
+bool FileClassification::isArchiveFile(const QString& filename)
+{
+    // (Archive's own table, so the two can't disagree)
+    for (int i = 0; *Archive::EXTENSIONS[i].ext != '\0'; i++)
+    {
+        if (filename.endsWith(Archive::EXTENSIONS[i].ext, Qt::CaseInsensitive))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 QString FileClassification::getFileDialogWildcardString()
 {
     int i;
@@ -44,10 +59,10 @@ QString FileClassification::getFileDialogWildcardString()
         str.append(' ');
     }
 
-    /*for (i = 0; *ARCHIVE_TYPES[i].ext != '\0'; i++)
+    /*for (i = 0; *Archive::EXTENSIONS[i].ext != '\0'; i++)
     {
         str.append('*');
-        str.append(ARCHIVE_TYPES[i].ext);
+        str.append(Archive::EXTENSIONS[i].ext);
         str.append(' ');
     }*/
 
@@ -68,10 +83,10 @@ QString FileClassification::getFileDialogWildcardString()
     str.append('\n');
 
     // Archive files
-    /*for (i = 0; *ARCHIVE_TYPES[i].ext != '\0'; i++)
+    /*for (i = 0; *Archive::EXTENSIONS[i].ext != '\0'; i++)
     {
         str.append('*');
-        str.append(ARCHIVE_TYPES[i].ext);
+        str.append(Archive::EXTENSIONS[i].ext);
         str.append(' ');
     }*/
 
@@ -7,6 +7,7 @@ class FileClassification
 {
 public:
     static bool isImageFile(const QByteArray& filename);
+    static bool isArchiveFile(const QString& filename);
     static QString getFileDialogWildcardString();
 
 private:
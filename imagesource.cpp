@@ -2,20 +2,28 @@
 
 #include <QProcess>
 
+#include <algorithm>
+
+#include <string.h>
+
 #include "debug.h"
 
 // QProcess used from a non-owner thread, calling waitFoReadyRead is
 // very unreliable (causes exit 141, SIGPIPE). So, the data is pulled
 // from the proxy using signals, and an off-thread wait condition.
-ImageSource::ImageSource(QIODevice *proxy, int fullSize, QObject *parent)
+//
+// The data is kept as a list of chunks (as they arrive from the proxy)
+// instead of one QByteArray, so entries bigger than 2 GB can be buffered.
+ImageSource::ImageSource(QIODevice *proxy, qint64 fullSize, QObject *parent)
     : QIODevice(parent)
 {
     _proxy = proxy;
     Q_ASSERT(_proxy->isReadable());
     setOpenMode(ReadOnly | Unbuffered);
-    _buffer.setData(_proxy->readAll());
-    _buffer.open(ReadOnly);
-    _fullSize = static_cast<qint64>(fullSize);
+    _bufferedSize = 0;
+    _pos = 0;
+    append(_proxy->readAll());
+    _fullSize = fullSize;
     _clock.start();
     connect(_proxy, SIGNAL(readyRead()), SLOT(proxyReadyRead()));
 }
@@ -34,7 +42,8 @@ void ImageSource::close()
     // Close this buffer and prevent new references (rely
     // on the proxy to get closed by other means)
     QMutexLocker locker(&_lock);
-    _buffer.close();
+    _chunks.clear();
+    _chunkStarts.clear();
     QIODevice::close();
     _ready.wakeOne();
 }
@@ -44,24 +53,34 @@ void ImageSource::proxyReadyRead()
     QMutexLocker locker(&_lock);
     if (isReadable())
     {
-        _buffer.buffer() += _proxy->readAll();
+        append(_proxy->readAll());
     }
     _ready.wakeOne();
 }
 
+void ImageSource::append(const QByteArray &data)
+{
+    if (!data.isEmpty())
+    {
+        _chunks<<data;
+        _chunkStarts<<_bufferedSize;
+        _bufferedSize += data.size();
+    }
+}
+
 void ImageSource::updateFromProxy()
 {
     qint64 targetSize = qMin(pos() + 1, _fullSize);
     bool problemWaiting = false;
 
-    while (!problemWaiting && _buffer.size() < targetSize)
+    while (!problemWaiting && _bufferedSize < targetSize)
     {
         problemWaiting =
             !_ready.wait(&_lock, WAIT_TIMEOUT)
             || !isReadable();
     }
 
-    if (problemWaiting && _buffer.size() < targetSize && isReadable())
+    if (problemWaiting && _bufferedSize < targetSize && isReadable())
     {
         QProcess *process = (QProcess *) _proxy;
         debug()<<"Problem!"<<process->exitCode()<<process->error()<<process->state()<<process->isReadable();
@@ -76,7 +95,30 @@ qint64 ImageSource::readData(char *data, qint64 maxSize)
         updateFromProxy();
         if (isReadable())
         {
-            return _buffer.read(data, maxSize);
+            // Nothing more has arrived
+            if (_pos >= _bufferedSize)
+            {
+                return 0;
+            }
+
+            // Find the chunk holding the current position
+            int chunk = int(std::upper_bound(_chunkStarts.begin(), _chunkStarts.end(), _pos)
+                - _chunkStarts.begin()) - 1;
+            qint64 read = 0;
+
+            // Copy across chunks until the request is filled
+            while (chunk >= 0 && chunk < _chunks.size() && read < maxSize)
+            {
+                qint64 offset = _pos - _chunkStarts[chunk];
+                qint64 length = qMin(maxSize - read, _chunks[chunk].size() - offset);
+
+                memcpy(data + read, _chunks[chunk].constData() + offset, length);
+                read += length;
+                _pos += length;
+                chunk++;
+            }
+
+            return read;
         }
         else
         {
@@ -93,18 +135,12 @@ bool ImageSource::seek(qint64 pos)
 {
     QMutexLocker locker(&_lock);
 
-    if (isReadable())
+    // No need to wait for the data here, reading will wait for it
+    if (isReadable() && pos <= qMax(_fullSize, _bufferedSize))
     {
-        updateFromProxy();
-        if (isReadable())
-        {
-            QIODevice::seek(pos);
-            return _buffer.seek(pos);
-        }
-        else
-        {
-            return false;
-        }
+        QIODevice::seek(pos);
+        _pos = pos;
+        return true;
     }
     else
     {
@@ -114,7 +150,7 @@ bool ImageSource::seek(qint64 pos)
 
 qint64 ImageSource::pos() const
 {
-    return _buffer.pos();
+    return _pos;
 }
 
 bool ImageSource::open(OpenMode mode)
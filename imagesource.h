@@ -3,7 +3,6 @@
 
 #include <QIODevice>
 
-#include <QBuffer>
 #include <QMutex>
 #include <QTime>
 #include <QWaitCondition>
@@ -13,7 +12,7 @@ class ImageSource : public QIODevice
     Q_OBJECT
 
 public:
-    ImageSource(QIODevice *proxy, int fullSize, QObject *parent = 0);
+    ImageSource(QIODevice *proxy, qint64 fullSize, QObject *parent = 0);
     ~ImageSource();
 
     qint64 bytesAvailable() const;
@@ -41,6 +40,7 @@ private slots:
 
 private:
     void updateFromProxy();
+    void append(const QByteArray &data);
 
 private:
     static const int WAIT_TIMEOUT = 3000;
@@ -50,7 +50,10 @@ private:
     QWaitCondition _ready;
     QIODevice *_proxy;
     QTime _clock;
-    QBuffer _buffer;
+    QList<QByteArray> _chunks;
+    QList<qint64> _chunkStarts;
+    qint64 _bufferedSize;
+    qint64 _pos;
     qint64 _fullSize;
 };
 
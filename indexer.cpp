@@ -1,48 +1,347 @@
 #include "indexer.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
 #include <algorithm>
 
+#include "archive.h"
 #include "archivelister.h"
 #include "debug.h"
+#include "fileclassification.h"
+#include "naturalorder.h"
+#include "trace.h"
 
 using std::sort;
 
+const qint32 Indexer::LISTING_VERSION = 2;
+
 Indexer::Indexer(const Archive &archive, QObject *parent)
     : QObject(parent), _archive(archive)
 {
     _archiveLister = NULL;
+    _extracter = NULL;
+    _extractTraceId = -1;
+    _extractionList = NULL;
+    _temporaryFolder = NULL;
+    _listingDirectory = false;
+
+    connect(&_directoryListing, SIGNAL(finished()), SLOT(directoryListed()));
+
+    clear();
 }
 
 Indexer::~Indexer()
 {
+    // Stop extracting before the temporary folder goes
+    stopListing();
+    delete _temporaryFolder;
+}
+
+/**
+ * Where inner archives are extracted to, and looked for when a listing is
+ * restored. Without one, they go in a temporary folder that lasts as long
+ * as the indexer.
+ */
+void Indexer::setExtractionFolder(const QString &folder)
+{
+    _extractionFolder = folder;
 }
 
 void Indexer::reset()
 {
-    // Stop any current lister
-    if (_archiveLister != NULL)
+    clear();
+
+    // There's nothing to list in an unreadable file
+    if (_archive.type() == Archive::InvalidArchiveType)
     {
-        delete _archiveLister;
+        _complete = true;
+        announce();
+        return;
     }
 
-    // Clear the current indexer
-    _files.clear();
+    // A pack lists itself, in order
+    if (_archive.type() == Archive::Pack)
+    {
+        listPack();
+        return;
+    }
+
+    // A folder is listed on the thread pool
+    if (_archive.type() == Archive::Directory)
+    {
+        _listingDirectory = true;
+        _directoryListing.setFuture(QtConcurrent::run(&Indexer::listDirectory, _archive.filename()));
+        return;
+    }
 
     // Create a new archive lister
     _archiveLister = new ArchiveLister(_archive, this);
+    _listingSource = -1;
 
     // Connect to it
-    connect(_archiveLister, SIGNAL(entryFound(const QByteArray &, int, int)),
-            SLOT(entryFound(const QByteArray &, int, int)));
+    connect(_archiveLister, SIGNAL(entryFound(const QByteArray &, qint64, qint64)),
+            SLOT(entryFound(const QByteArray &, qint64, qint64)));
+    connect(_archiveLister, SIGNAL(archiveFound(const QByteArray &, qint64, qint64)),
+            SLOT(archiveFound(const QByteArray &, qint64, qint64)));
     connect(_archiveLister, SIGNAL(finished()), SLOT(listingFinished()));
 
     // Start it
     _archiveLister->start();
+}
+
+/**
+ * List the archive without returning to the event loop. The signals are
+ * still emitted, from inside this call.
+ */
+void Indexer::build()
+{
+    if (_archive.type() == Archive::Directory)
+    {
+        clear();
+        finishDirectory(listDirectory(_archive.filename()));
+        return;
+    }
+
+    reset();
+
+    // Wait on each lister and extracter in turn
+    while (!_complete)
+    {
+        ArchiveLister *lister = _archiveLister;
+        QProcess *extracter = _extracter;
+
+        if (lister != NULL)
+        {
+            lister->wait();
+        }
+        else if (extracter != NULL)
+        {
+            extracter->waitForFinished(-1);
+        }
+
+        // (A program that never started won't move things on)
+        if (_archiveLister == lister && _extracter == extracter)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * Take the complete listing another indexer already built, as if this one
+ * had just built it.
+ */
+void Indexer::adopt(const Indexer &other)
+{
+    Q_ASSERT(other.isComplete());
+    clear();
+
+    _files = other._files;
+    _innerNames = other._innerNames;
+    _folderIdentity = other._folderIdentity;
+
+    foreach (const Archive *otherInner, other._inner)
+    {
+        Archive *inner = new Archive(this);
+        inner->reset(otherInner->filename());
+        _inner<<inner;
+    }
+
+    _complete = true;
+    announce();
+}
+
+/**
+ * Use a listing saved from an earlier build, returning false (and leaving
+ * the indexer alone) if it can't be read, or its inner archives are no
+ * longer extracted.
+ */
+bool Indexer::restore(const QByteArray &listing)
+{
+    QDataStream in(listing);
+    qint32 version;
+    qint32 count;
+    in>>version>>count;
+
+    // (Each entry takes at least 24 bytes, so a bad count can be caught)
+    if (in.status() != QDataStream::Ok || version != LISTING_VERSION
+        || count <= 0 || qint64(count) * 24 > listing.size())
+    {
+        return false;
+    }
+
+    vector<FileInfo> files(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        qint32 source;
+        in>>files[i].name>>files[i].compressedSize>>files[i].uncompressedSize>>source;
+        files[i].source = source;
+        files[i].isArchive = false;
+    }
+
+    qint32 innerCount;
+    in>>innerCount;
+
+    if (in.status() != QDataStream::Ok || innerCount < 0 || innerCount > count)
+    {
+        return false;
+    }
+
+    QList<QByteArray> innerNames;
+
+    for (int i = 0; i < innerCount; i++)
+    {
+        QByteArray name;
+        in>>name;
+        innerNames<<name;
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (files[i].source < -1 || files[i].source >= innerCount)
+        {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < innerCount; i++)
+    {
+        if (!QFileInfo(innerPath(i, innerNames[i])).exists())
+        {
+            return false;
+        }
+    }
+
+    clear();
+
+    for (int i = 0; i < innerCount; i++)
+    {
+        Archive *inner = new Archive(this);
+        inner->reset(innerPath(i, innerNames[i]));
+        touch(inner->filename());
+        _inner<<inner;
+    }
+
+    _files.swap(files);
+    _innerNames = innerNames;
+    _complete = true;
+    announce();
+    return true;
+}
+
+/**
+ * The sorted listing, for restore(). Only the complete listing is worth
+ * keeping.
+ */
+QByteArray Indexer::listing() const
+{
+    Q_ASSERT(_complete);
+
+    QByteArray listing;
+    QDataStream out(&listing, QIODevice::WriteOnly);
+    out<<LISTING_VERSION<<qint32(_files.size());
+
+    for (size_t i = 0; i < _files.size(); i++)
+    {
+        out<<_files[i].name<<_files[i].compressedSize<<_files[i].uncompressedSize
+            <<qint32(_files[i].source);
+    }
+
+    out<<qint32(_innerNames.size());
+
+    foreach (const QByteArray &name, _innerNames)
+    {
+        out<<name;
+    }
+
+    return listing;
+}
+
+/**
+ * Whether every page has been listed (otherwise grown() is still to come).
+ */
+bool Indexer::isComplete() const
+{
+    return _complete;
+}
+
+/**
+ * Once a folder is listed, an identity taken from its images (their names,
+ * sizes and times), as the folder's own time doesn't change when an image
+ * is replaced in place. Empty for anything else.
+ */
+const QByteArray &Indexer::folderIdentity() const
+{
+    return _folderIdentity;
+}
+
+/**
+ * Forget the book, stopping any listing.
+ */
+void Indexer::clear()
+{
+    stopListing();
+
+    _files.clear();
+    _outer.clear();
+    _nextOuter = 0;
+    _found.clear();
+    _listingSource = -1;
+
+    qDeleteAll(_inner);
+    _inner.clear();
+    _innerNames.clear();
+
+    _folderIdentity.clear();
+    _complete = false;
+    _numAnnounced = 0;
+    _builtAnnounced = false;
 
     // Start timing
     _listingTime.restart();
 }
 
+/**
+ * Stop any current lister or extracter (a folder being listed just has its
+ * result ignored).
+ */
+void Indexer::stopListing()
+{
+    if (_archiveLister != NULL)
+    {
+        delete _archiveLister;
+        _archiveLister = NULL;
+    }
+
+    if (_extracter != NULL)
+    {
+        Trace::asyncEnd("extract", _extractTraceId);
+        delete _extracter;
+        _extracter = NULL;
+    }
+
+    delete _extractionList;
+    _extractionList = NULL;
+
+    _listingDirectory = false;
+}
+
 int Indexer::numPages() const
 {
     return _files.size();
@@ -54,25 +353,190 @@ QByteArray Indexer::pageName(int index) const
     return _files[index].name;
 }
 
-int Indexer::uncompressedSize(int index) const
+qint64 Indexer::uncompressedSize(int index) const
 {
     Q_ASSERT(index >= 0 && index < (int) _files.size());
     return _files[index].uncompressedSize;
 }
 
-void Indexer::entryFound(const QByteArray &filename, int compressedSize, int uncompressedSize)
+/**
+ * The index of the page named @a name, or -1.
+ */
+int Indexer::findPage(const QByteArray &name) const
+{
+    for (size_t i = 0; i < _files.size(); i++)
+    {
+        if (_files[i].name == name)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * The archive a page is extracted from: the book's own, or an inner one.
+ */
+const Archive &Indexer::pageArchive(int index) const
+{
+    Q_ASSERT(index >= 0 && index < (int) _files.size());
+    int source = _files[index].source;
+
+    return source == -1 ? _archive : *_inner[source];
+}
+
+void Indexer::entryFound(const QByteArray &filename, qint64 compressedSize, qint64 uncompressedSize)
 {
     // Add the entry to the list
     FileInfo temp;
     temp.name = filename;
     temp.compressedSize = compressedSize;
     temp.uncompressedSize = uncompressedSize;
-    _files.push_back(temp);
+    temp.source = _listingSource;
+    temp.isArchive = false;
+    _found.push_back(temp);
+}
+
+/**
+ * Only archives a program can list are taken (a pack inside an archive
+ * isn't worth extracting).
+ */
+void Indexer::archiveFound(const QByteArray &filename, qint64 compressedSize, qint64 uncompressedSize)
+{
+    if (_archive.typeOf(QString::fromLocal8Bit(filename)) >= Archive::NUM_PROGRAMS)
+    {
+        return;
+    }
+
+    FileInfo temp;
+    temp.name = filename;
+    temp.compressedSize = compressedSize;
+    temp.uncompressedSize = uncompressedSize;
+    temp.source = -1;
+    temp.isArchive = true;
+    _found.push_back(temp);
+}
+
+/**
+ * Pages are named by number, and sized by their mapped bytes.
+ */
+void Indexer::listPack()
+{
+    const PackFile &pack = _archive.pack();
+    _files.resize(pack.numPages());
+
+    for (int i = 0; i < pack.numPages(); i++)
+    {
+        _files[i].name = QByteArray::number(i);
+        _files[i].compressedSize = pack.pageBytes(i);
+        _files[i].uncompressedSize = pack.pageBytes(i);
+        _files[i].source = -1;
+        _files[i].isArchive = false;
+    }
+
+    debug()<<"Pack listed --"<<_files.size()<<"entries";
+
+    _complete = true;
+    announce();
+}
+
+/**
+ * Runs on the thread pool. The names come with their types, so only the
+ * images are stat'd, and those all at once.
+ */
+Indexer::Folder Indexer::listDirectory(const QString &path)
+{
+    TraceScope scope("list folder");
+
+    QStringList names;
+    QDirIterator i(path, QDir::Files);
+
+    while (i.hasNext())
+    {
+        i.next();
+
+        if (FileClassification::isImageFile(QFile::encodeName(i.fileName())))
+        {
+            names<<i.fileName();
+        }
+    }
+
+    NaturalOrder::sort(names);
+
+    QDir dir(path);
+    QStringList paths;
+
+    foreach (const QString &name, names)
+    {
+        paths<<dir.filePath(name);
+    }
+
+    QList<QPair<qint64, qint64> > stats = QtConcurrent::blockingMapped(paths, &Indexer::fileStat);
+    Folder folder;
+    folder.files.resize(names.size());
+
+    // Identify it by where it is, then by its images
+    QFileInfo info(path);
+    QCryptographicHash identity(QCryptographicHash::Sha1);
+    identity.addData(info.absoluteFilePath().toUtf8());
+    identity.addData(QByteArray::number(info.size()));
+    identity.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+
+    for (int i = 0; i < names.size(); i++)
+    {
+        FileInfo &file = folder.files[i];
+        file.name = QFile::encodeName(names[i]);
+        file.compressedSize = stats[i].first;
+        file.uncompressedSize = stats[i].first;
+        file.source = -1;
+        file.isArchive = false;
+
+        identity.addData(file.name);
+        identity.addData(QByteArray::number(stats[i].first));
+        identity.addData(QByteArray::number(stats[i].second));
+    }
+
+    folder.identity = identity.result().toHex();
+    return folder;
+}
+
+/**
+ * The size and modification time (in ms).
+ */
+QPair<qint64, qint64> Indexer::fileStat(const QString &path)
+{
+    QFileInfo info(path);
+    return qMakePair(info.size(), info.lastModified().toMSecsSinceEpoch());
+}
+
+void Indexer::directoryListed()
+{
+    // Ignore a folder that's no longer wanted
+    if (!_listingDirectory)
+    {
+        return;
+    }
+
+    finishDirectory(_directoryListing.result());
+}
+
+void Indexer::finishDirectory(const Folder &folder)
+{
+    _listingDirectory = false;
+    _files = folder.files;
+    _folderIdentity = folder.identity;
+
+    debug()<<"Folder listed:"<<_listingTime.elapsed()<<" ms"
+            <<"--"<<_files.size()<<"entries";
+
+    _complete = true;
+    announce();
 }
 
 bool Indexer::FileInfo::operator < (const Indexer::FileInfo &other) const
 {
-    return QString::localeAwareCompare(QString::fromLocal8Bit(name), QString::fromLocal8Bit(other.name)) < 0;
+    return NaturalOrder::lessThan(QString::fromLocal8Bit(name), QString::fromLocal8Bit(other.name));
 }
 
 void Indexer::listingFinished()
@@ -82,16 +546,216 @@ void Indexer::listingFinished()
     _archiveLister = NULL;
 
     // Sort all the entries
-    sort(_files.begin(), _files.end());
+    sort(_found.begin(), _found.end());
 
-    // Notify the steward
-    debug()<<"Listing finished:"<<_listingTime.elapsed()<<" ms"
-            <<"--"<<_files.size()<<"entries";
+    // The book's own entries are put in line as the inner archives are
+    // listed, and an inner archive's pages take its place
+    if (_listingSource == -1)
+    {
+        _outer.swap(_found);
+        _nextOuter = 0;
+    }
+    else
+    {
+        _files.insert(_files.end(), _found.begin(), _found.end());
+        _nextOuter++;
+    }
+    _found.clear();
 
-    if (_files.size() > 0)
+    listNext();
+}
+
+/**
+ * Take the book's pages up to its next inner archive, and start on that.
+ */
+void Indexer::listNext()
+{
+    while (true)
     {
-        debug()<<"File"<<_files.front().name;
+        while (_nextOuter < _outer.size() && !_outer[_nextOuter].isArchive)
+        {
+            _files.push_back(_outer[_nextOuter]);
+            _nextOuter++;
+        }
+
+        if (_nextOuter >= _outer.size())
+        {
+            _complete = true;
+            break;
+        }
+
+        if (startInner(_outer[_nextOuter]))
+        {
+            break;
+        }
+
+        // Leave out an inner archive that can't be read
+        _nextOuter++;
     }
 
-    emit built();
+    if (_complete)
+    {
+        // Notify the steward
+        debug()<<"Listing finished:"<<_listingTime.elapsed()<<" ms"
+                <<"--"<<_files.size()<<"entries,"<<_inner.size()<<"inner archives";
+
+        if (_files.size() > 0)
+        {
+            debug()<<"File"<<_files.front().name;
+        }
+    }
+
+    announce();
+}
+
+/**
+ * Extract an inner archive (unless it was on an earlier opening), to be
+ * listed once it's out.
+ */
+bool Indexer::startInner(const FileInfo &entry)
+{
+    QString path = innerPath(_inner.size(), entry.name);
+    QFileInfo cached(path);
+
+    if (cached.exists() && cached.size() == entry.uncompressedSize)
+    {
+        touch(path);
+        return listInner(entry, path);
+    }
+
+    // (Written under another name, so a partial file is never taken as done)
+    delete _extractionList;
+    _extractionList = new QTemporaryFile();
+
+    _extracter = new QProcess(this);
+    _extracter->setStandardOutputFile(path + ".part");
+    connect(_extracter, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(innerExtracted()));
+    connect(_extracter, SIGNAL(error(QProcess::ProcessError)), SLOT(innerExtracted()));
+    _extractionPath = path;
+
+    _extractTraceId = Trace::newId();
+    Trace::asyncBegin("extract", _extractTraceId);
+    _extracter->start(_archive.programPath(),
+        _archive.extractionArguments(entry.name, *_extractionList));
+
+    return true;
+}
+
+void Indexer::innerExtracted()
+{
+    // (Both signals come when the extracter crashes)
+    if (_extracter == NULL)
+    {
+        return;
+    }
+
+    bool done = _extracter->error() == QProcess::UnknownError
+        && _extracter->exitStatus() == QProcess::NormalExit
+        && _extracter->exitCode() == 0;
+
+    Trace::asyncEnd("extract", _extractTraceId);
+    _extracter->disconnect(this);
+    _extracter->deleteLater();
+    _extracter = NULL;
+
+    QFile::remove(_extractionPath);
+    done = done && QFile::rename(_extractionPath + ".part", _extractionPath);
+
+    if (!done)
+    {
+        debug()<<"Couldn't extract"<<_outer[_nextOuter].name;
+        QFile::remove(_extractionPath + ".part");
+    }
+    else
+    {
+        emit extracted(QFileInfo(_extractionPath).size());
+    }
+
+    if (!done || !listInner(_outer[_nextOuter], _extractionPath))
+    {
+        _nextOuter++;
+        listNext();
+    }
+}
+
+/**
+ * List an extracted inner archive (its own inner archives are left out).
+ */
+bool Indexer::listInner(const FileInfo &entry, const QString &path)
+{
+    if (_archive.typeOf(path) >= Archive::NUM_PROGRAMS)
+    {
+        return false;
+    }
+
+    Archive *inner = new Archive(this);
+    inner->reset(path);
+    _inner<<inner;
+    _innerNames<<entry.name;
+
+    _archiveLister = new ArchiveLister(*inner, this);
+    _listingSource = _inner.size() - 1;
+
+    connect(_archiveLister, SIGNAL(entryFound(const QByteArray &, qint64, qint64)),
+            SLOT(entryFound(const QByteArray &, qint64, qint64)));
+    connect(_archiveLister, SIGNAL(finished()), SLOT(listingFinished()));
+
+    _archiveLister->start();
+    return true;
+}
+
+/**
+ * Built once there's something to show (or nothing ever will be), then
+ * grown as more comes.
+ */
+void Indexer::announce()
+{
+    if (!_builtAnnounced)
+    {
+        if (!_files.empty() || _complete)
+        {
+            _builtAnnounced = true;
+            _numAnnounced = _files.size();
+            emit built();
+        }
+    }
+    else if (_files.size() > _numAnnounced || _complete)
+    {
+        _numAnnounced = _files.size();
+        emit grown();
+    }
+}
+
+/**
+ * Mark an extracted inner archive as recently used, so the disk cache keeps
+ * it over older files.
+ */
+void Indexer::touch(const QString &path)
+{
+    QFile(path).setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+}
+
+/**
+ * Inner archives are named by their place in the book, keeping the type
+ * (which is judged by it).
+ */
+QString Indexer::innerPath(int source, const QByteArray &name)
+{
+    QString folder = _extractionFolder;
+
+    if (folder.isEmpty())
+    {
+        if (_temporaryFolder == NULL)
+        {
+            _temporaryFolder = new QTemporaryDir();
+        }
+
+        folder = _temporaryFolder->path();
+    }
+
+    QDir().mkpath(folder);
+
+    return QDir(folder).filePath(QString("%1.%2")
+        .arg(source)
+        .arg(QFileInfo(QString::fromLocal8Bit(name)).suffix().toLower()));
 }
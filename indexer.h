@@ -3,16 +3,31 @@
 
 #include <QObject>
 
+#include <QFutureWatcher>
+#include <QList>
+#include <QPair>
 #include <QTime>
 
 #include <vector>
 
 using std::vector;
 
+class QProcess;
+class QTemporaryDir;
+class QTemporaryFile;
+
 class Archive;
 class ArchiveLister;
 
 /**
+ * @brief Lists the pages of a book.
+ *
+ * Archives inside the archive (a book of chapters, say) are extracted once
+ * into the extraction folder, listed in turn, and their pages put in line
+ * with the rest, as one book. As the listing can take a while, built() comes
+ * as soon as the first pages are ready, and grown() as each inner archive
+ * adds its pages.
+ *
  * @todo Use QByteArray for the filenames (to overcome text codec errors)
  */
 class Indexer : public QObject
@@ -23,34 +38,98 @@ public:
     Indexer(const Archive &archive, QObject *parent = NULL);
     ~Indexer();
 
+    void setExtractionFolder(const QString &folder);
+
     void reset();
+    void build();
+    void adopt(const Indexer &other);
+    bool restore(const QByteArray &listing);
+    QByteArray listing() const;
+    bool isComplete() const;
+    const QByteArray &folderIdentity() const;
 
     int numPages() const;
     QByteArray pageName(int index) const;
-    int uncompressedSize(int index) const;
+    qint64 uncompressedSize(int index) const;
+    int findPage(const QByteArray &name) const;
+    const Archive &pageArchive(int index) const;
 
 signals:
     void built();
+    void grown();
+    void extracted(qint64 bytes);
 
 private slots:
-    void entryFound(const QByteArray &filename, int compressedSize, int uncompressedSize);
+    void entryFound(const QByteArray &filename, qint64 compressedSize, qint64 uncompressedSize);
+    void archiveFound(const QByteArray &filename, qint64 compressedSize, qint64 uncompressedSize);
     void listingFinished();
+    void directoryListed();
+    void innerExtracted();
 
 private:
     struct FileInfo
     {
         QByteArray name;
-        int compressedSize;
-        int uncompressedSize;
+        qint64 compressedSize;
+        qint64 uncompressedSize;
+
+        /** The inner archive it's in, or -1 */
+        int source;
+        bool isArchive;
 
         bool operator < (const FileInfo &other) const;
     };
 
+    struct Folder
+    {
+        vector<FileInfo> files;
+        QByteArray identity;
+    };
+
+private:
+    void clear();
+    void stopListing();
+    void listPack();
+    void listNext();
+    bool startInner(const FileInfo &entry);
+    bool listInner(const FileInfo &entry, const QString &path);
+    void announce();
+    QString innerPath(int source, const QByteArray &name);
+    static void touch(const QString &path);
+    static Folder listDirectory(const QString &path);
+    static QPair<qint64, qint64> fileStat(const QString &path);
+    void finishDirectory(const Folder &folder);
+
+private:
+    static const qint32 LISTING_VERSION;
+
 private:
     const Archive &_archive;
     vector<FileInfo> _files;
 
+    /** The book's own entries, sorted, with its inner archives among them */
+    vector<FileInfo> _outer;
+    size_t _nextOuter;
+    vector<FileInfo> _found;
+    int _listingSource;
+
+    QList<Archive *> _inner;
+    QList<QByteArray> _innerNames;
+    bool _complete;
+    size_t _numAnnounced;
+    bool _builtAnnounced;
+
     ArchiveLister *_archiveLister;
+    QProcess *_extracter;
+    qint64 _extractTraceId;
+    QTemporaryFile *_extractionList;
+    QString _extractionPath;
+    QString _extractionFolder;
+    QTemporaryDir *_temporaryFolder;
+
+    QFutureWatcher<Folder> _directoryListing;
+    bool _listingDirectory;
+    QByteArray _folderIdentity;
     QTime _listingTime;
 };
 
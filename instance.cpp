@@ -0,0 +1,141 @@
+#include "instance.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QLocalSocket>
+#include <QTimer>
+
+#include "debug.h"
+
+const int Instance::CONNECT_WAIT = 500;
+const int Instance::REPLY_WAIT = 2000;
+const int Instance::REQUEST_WAIT = 2000;
+
+Instance::Instance(QObject *parent)
+    : QObject(parent)
+{
+    connect(&_server, SIGNAL(newConnection()), SLOT(newConnection()));
+}
+
+Instance::~Instance()
+{
+}
+
+/**
+ * Hand @a filename (absolute, or empty to just bring the window up) to the
+ * running instance. NotRunning means nothing is listening on the socket
+ * (at most a file left by a crash); NotAnswering means something is, but it
+ * may just be busy.
+ */
+Instance::ForwardResult Instance::forward(const QString &filename)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+
+    if (!socket.waitForConnected(CONNECT_WAIT))
+    {
+        if (socket.error() == QLocalSocket::ServerNotFoundError
+            || socket.error() == QLocalSocket::ConnectionRefusedError)
+        {
+            return NotRunning;
+        }
+
+        debug()<<"Can't reach running instance"<<socket.errorString();
+        return NotAnswering;
+    }
+
+    // One line out, one line back
+    socket.write(filename.toUtf8() + '\n');
+
+    while (!socket.canReadLine())
+    {
+        if (!socket.waitForReadyRead(REPLY_WAIT))
+        {
+            debug()<<"Running instance didn't answer";
+            return NotAnswering;
+        }
+    }
+
+    return socket.readLine().trimmed() == "ok" ? Forwarded : NotAnswering;
+}
+
+/**
+ * Become the running instance, given how forwarding to it went.
+ */
+void Instance::listen(ForwardResult forwarded)
+{
+    if (_server.listen(serverName()))
+    {
+        return;
+    }
+
+    // Only a socket nothing is listening on is taken over (one that's just
+    // slow, or was started at the same time, keeps it)
+    if (_server.serverError() == QAbstractSocket::AddressInUseError
+        && forwarded == NotRunning && !isListening())
+    {
+        QLocalServer::removeServer(serverName());
+
+        if (_server.listen(serverName()))
+        {
+            return;
+        }
+    }
+
+    debug()<<"Can't listen for other instances"<<_server.errorString();
+}
+
+/**
+ * Whether another instance is listening on the socket now.
+ */
+bool Instance::isListening()
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+
+    return socket.waitForConnected(CONNECT_WAIT);
+}
+
+void Instance::newConnection()
+{
+    while (_server.hasPendingConnections())
+    {
+        QLocalSocket *socket = _server.nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), SLOT(readRequest()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+
+        // Don't keep a silent connection around
+        QTimer::singleShot(REQUEST_WAIT, socket, SLOT(deleteLater()));
+    }
+}
+
+void Instance::readRequest()
+{
+    QLocalSocket *socket = static_cast<QLocalSocket *>(sender());
+
+    if (!socket->canReadLine())
+    {
+        return;
+    }
+
+    // (Only the newline is dropped, as names can have other whitespace)
+    QByteArray line = socket->readLine();
+    line.chop(1);
+    QString filename = QString::fromUtf8(line);
+
+    // Answer first, so the other process can exit right away
+    socket->write("ok\n");
+    socket->flush();
+    socket->disconnectFromServer();
+
+    emit fileRequested(filename);
+}
+
+/**
+ * Per user, so different users each get their own window.
+ */
+QString Instance::serverName()
+{
+    return "yomikata-" + QString::fromLatin1(
+        QCryptographicHash::hash(QDir::homePath().toUtf8(), QCryptographicHash::Md5).toHex());
+}
@@ -0,0 +1,56 @@
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <QObject>
+
+#include <QLocalServer>
+
+/**
+ * @brief Keeps to one running window per user, so books opened from outside
+ * go to the process that's already warm.
+ *
+ * The first instance listens on a local socket. Later ones send it their
+ * file and exit, unless it doesn't answer in time, in which case they carry
+ * on as a new instance (leaving the socket to the busy one).
+ */
+class Instance : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** How handing a file to the running instance went */
+    enum ForwardResult
+    {
+        Forwarded = 0,
+        NotRunning,
+        NotAnswering
+    };
+
+public:
+    Instance(QObject *parent = NULL);
+    ~Instance();
+
+    ForwardResult forward(const QString &filename);
+    void listen(ForwardResult forwarded);
+
+signals:
+    void fileRequested(const QString &filename);
+
+private slots:
+    void newConnection();
+    void readRequest();
+
+private:
+    static bool isListening();
+    static QString serverName();
+
+private:
+    static const int CONNECT_WAIT;
+    static const int REPLY_WAIT;
+    static const int REQUEST_WAIT;
+
+private:
+    QLocalServer _server;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "latencymeter.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include "debug.h"
+#include "trace.h"
+
+LatencyMeter::LatencyMeter(int capacity)
+    : _inputToDecoded(capacity), _inputToPainted(capacity)
+{
+    _capacity = capacity;
+    _sequence = 0;
+    _dropped = 0;
+    _pending = false;
+    _inputTime = 0.0;
+    _decodedTime = -1.0;
+
+    _clock.start();
+}
+
+LatencyMeter::~LatencyMeter()
+{
+}
+
+/**
+ * Starts timing a navigation, returning its sequence number.
+ */
+int LatencyMeter::input()
+{
+    // The previous navigation never made it to the screen
+    if (_pending)
+    {
+        _dropped++;
+    }
+
+    _sequence++;
+    _pending = true;
+    _inputTime = elapsed();
+    _decodedTime = -1.0;
+
+    Trace::instant("input", _sequence);
+    return _sequence;
+}
+
+void LatencyMeter::decoded()
+{
+    if (!_pending || _decodedTime >= 0.0)
+    {
+        return;
+    }
+
+    _decodedTime = elapsed();
+    _inputToDecoded.addSample(_decodedTime - _inputTime);
+
+    Trace::instant("decoded", _sequence);
+}
+
+/**
+ * Only the first paint after the pages are ready counts.
+ */
+void LatencyMeter::painted()
+{
+    if (!_pending || _decodedTime < 0.0)
+    {
+        return;
+    }
+
+    double paintedTime = elapsed();
+    _inputToPainted.addSample(paintedTime - _inputTime);
+    _pending = false;
+
+    Trace::instant("painted", _sequence);
+
+    // Keep the recent history for exporting
+    Record record = {_sequence, _decodedTime - _inputTime, paintedTime - _inputTime};
+    _records.append(record);
+
+    if (_records.size() > _capacity)
+    {
+        _records.removeFirst();
+    }
+}
+
+int LatencyMeter::sequence() const
+{
+    return _sequence;
+}
+
+int LatencyMeter::dropped() const
+{
+    return _dropped;
+}
+
+const Distribution &LatencyMeter::inputToDecoded() const
+{
+    return _inputToDecoded;
+}
+
+const Distribution &LatencyMeter::inputToPainted() const
+{
+    return _inputToPainted;
+}
+
+/**
+ * Writes the recent navigations as CSV, one per line.
+ */
+bool LatencyMeter::exportCsv(const QString &filename) const
+{
+    QFile file(filename);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        debug()<<"Can't export latencies to"<<filename;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out<<"sequence,input_to_decoded_ms,input_to_painted_ms\n";
+
+    foreach (const Record &record, _records)
+    {
+        out<<record.sequence<<","
+            <<QString::number(record.decodedMs, 'f', 3)<<","
+            <<QString::number(record.paintedMs, 'f', 3)<<"\n";
+    }
+
+    return true;
+}
+
+double LatencyMeter::elapsed() const
+{
+    return double(_clock.nsecsElapsed()) / 1000000.0;
+}
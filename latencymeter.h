@@ -0,0 +1,61 @@
+#ifndef LATENCYMETER_H
+#define LATENCYMETER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+#include "distribution.h"
+
+/**
+ * @brief Input-to-paint latency of page turns.
+ *
+ * Each navigation gets a sequence number and is timestamped when the input
+ * arrives, when all its pages are ready to show, and when they are first
+ * painted. A navigation that's overtaken by the next one is dropped.
+ */
+class LatencyMeter
+{
+public:
+    struct Record
+    {
+        int sequence;
+        double decodedMs;
+        double paintedMs;
+    };
+
+public:
+    LatencyMeter(int capacity);
+    ~LatencyMeter();
+
+    int input();
+    void decoded();
+    void painted();
+
+    int sequence() const;
+    int dropped() const;
+
+    const Distribution &inputToDecoded() const;
+    const Distribution &inputToPainted() const;
+
+    bool exportCsv(const QString &filename) const;
+
+private:
+    double elapsed() const;
+
+private:
+    QElapsedTimer _clock;
+    int _capacity;
+
+    int _sequence;
+    int _dropped;
+    bool _pending;
+    double _inputTime;
+    double _decodedTime;
+
+    Distribution _inputToDecoded;
+    Distribution _inputToPainted;
+    QList<Record> _records;
+};
+
+#endif
@@ -0,0 +1,424 @@
+#include "library.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrentMap>
+
+#include "archive.h"
+#include "debug.h"
+#include "fileclassification.h"
+#include "indexer.h"
+#include "trace.h"
+
+const quint32 Library::MAGIC = 0x594b4c42;
+const qint32 Library::VERSION = 1;
+const int Library::COVER_HEIGHT = 256;
+const int Library::EXTRACT_WAIT = 30000;
+const int Library::SAVE_INTERVAL = 256;
+
+/**
+ * The index and covers are kept in @a location, by default the user's data
+ * directory.
+ */
+Library::Library(const QString &location, QObject *parent)
+    : QObject(parent)
+{
+    _numExamined = 0;
+    _unsaved = 0;
+    _traceId = -1;
+
+    if (location.isEmpty())
+    {
+        _location = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    }
+    else
+    {
+        _location = QDir(location);
+    }
+    _location.mkpath("covers");
+
+    // Test the archivers here, rather than from every thread at once
+    Archive archive;
+
+    connect(&_walk, SIGNAL(finished()), SLOT(walkFinished()));
+    connect(&_examine, SIGNAL(resultReadyAt(int)), SLOT(entryExamined(int)));
+    connect(&_examine, SIGNAL(progressValueChanged(int)), SLOT(examineProgress(int)));
+    connect(&_examine, SIGNAL(finished()), SLOT(examineFinished()));
+
+    load();
+}
+
+Library::~Library()
+{
+    // Stop scanning, keeping what's been found so far
+    _walk.cancel();
+    _examine.cancel();
+    _walk.waitForFinished();
+    _examine.waitForFinished();
+
+    if (_unsaved > 0)
+    {
+        save();
+    }
+
+    // End the scan's span, if it was stopped partway
+    if (_traceId != -1)
+    {
+        Trace::asyncEnd("scan", _traceId);
+    }
+}
+
+/**
+ * Bring the index up to date with every archive under @a roots.
+ */
+void Library::scan(const QStringList &roots)
+{
+    Q_ASSERT(!isScanning());
+
+    _roots.clear();
+    _rootFiles.clear();
+    _numExamined = 0;
+    _scanTime.restart();
+    _traceId = Trace::newId();
+    Trace::asyncBegin("scan", _traceId);
+
+    // Archives at the top are taken here; each folder is walked in parallel
+    QStringList folders;
+
+    foreach (const QString &root, roots)
+    {
+        QDir dir(root);
+        _roots<<dir.absolutePath();
+
+        foreach (const QFileInfo &info, dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            if (info.isDir())
+            {
+                folders<<info.absoluteFilePath();
+            }
+            else if (FileClassification::isArchiveFile(info.fileName()))
+            {
+                _rootFiles<<stat(info);
+            }
+        }
+    }
+
+    _walk.setFuture(QtConcurrent::mapped(folders, &Library::walk));
+}
+
+bool Library::isScanning() const
+{
+    return _walk.isRunning() || _examine.isRunning();
+}
+
+/**
+ * Every archive known, in order of path.
+ */
+QList<Library::Entry> Library::entries() const
+{
+    return _entries.values();
+}
+
+/**
+ * How many archives the last scan had to list (new or changed ones).
+ */
+int Library::numExamined() const
+{
+    return _numExamined;
+}
+
+QList<Library::Entry> Library::walk(const QString &directory)
+{
+    QList<Entry> found;
+    QDirIterator i(directory, QDir::Files, QDirIterator::Subdirectories);
+
+    while (i.hasNext())
+    {
+        i.next();
+
+        if (FileClassification::isArchiveFile(i.fileName()))
+        {
+            found<<stat(i.fileInfo());
+        }
+    }
+
+    return found;
+}
+
+Library::Entry Library::stat(const QFileInfo &info)
+{
+    Entry entry;
+    entry.path = info.absoluteFilePath();
+    entry.size = info.size();
+    entry.modified = info.lastModified().toMSecsSinceEpoch();
+    entry.numPages = 0;
+    entry.bytes = 0;
+    return entry;
+}
+
+void Library::walkFinished()
+{
+    // Gather everything found on disk
+    QMap<QString, Entry> found;
+
+    foreach (const Entry &entry, _rootFiles)
+    {
+        found[entry.path] = entry;
+    }
+
+    for (int i = 0; i < _walk.future().resultCount(); i++)
+    {
+        foreach (const Entry &entry, _walk.resultAt(i))
+        {
+            found[entry.path] = entry;
+        }
+    }
+    _rootFiles.clear();
+
+    // Forget archives that have gone
+    QMap<QString, Entry>::iterator i = _entries.begin();
+
+    while (i != _entries.end())
+    {
+        if (isUnder(i.key()) && !found.contains(i.key()))
+        {
+            removeCover(*i);
+            i = _entries.erase(i);
+            _unsaved++;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // Only list the new and changed ones
+    QList<Entry> changed;
+
+    foreach (const Entry &entry, found)
+    {
+        QMap<QString, Entry>::const_iterator known = _entries.constFind(entry.path);
+
+        if (known == _entries.constEnd()
+            || known->size != entry.size
+            || known->modified != entry.modified)
+        {
+            changed<<entry;
+        }
+    }
+
+    debug()<<"Library walked:"<<_scanTime.elapsed()<<"ms --"
+        <<found.size()<<"archives,"<<changed.size()<<"changed";
+
+    Examiner examiner;
+    examiner.coverFolder = _location.filePath("covers");
+    _examine.setFuture(QtConcurrent::mapped(changed, examiner));
+}
+
+void Library::entryExamined(int index)
+{
+    Entry entry = _examine.resultAt(index);
+
+    // Replace the old cover
+    if (_entries.contains(entry.path) && _entries[entry.path].cover != entry.cover)
+    {
+        removeCover(_entries[entry.path]);
+    }
+
+    _entries[entry.path] = entry;
+    _numExamined++;
+
+    // Save as we go, in case scanning is interrupted
+    if (++_unsaved >= SAVE_INTERVAL)
+    {
+        save();
+    }
+}
+
+void Library::examineProgress(int done)
+{
+    emit progress(done, _examine.progressMaximum());
+}
+
+void Library::examineFinished()
+{
+    if (_unsaved > 0)
+    {
+        save();
+    }
+
+    debug()<<"Library scanned:"<<_scanTime.elapsed()<<"ms --"
+        <<_entries.size()<<"archives,"<<_numExamined<<"listed";
+    Trace::asyncEnd("scan", _traceId);
+    _traceId = -1;
+
+    emit scanned();
+}
+
+Library::Entry Library::Examiner::operator()(const Entry &found) const
+{
+    TraceScope scope("examine");
+    Entry entry = found;
+
+    // List the pages (an unreadable file is kept without any, so it isn't
+    // examined again until it changes)
+    Archive archive;
+
+    if (!archive.reset(entry.path))
+    {
+        debug()<<"Unreadable"<<entry.path;
+        return entry;
+    }
+
+    Indexer indexer(archive);
+    indexer.build();
+
+    entry.numPages = indexer.numPages();
+
+    for (int i = 0; i < indexer.numPages(); i++)
+    {
+        entry.bytes += indexer.uncompressedSize(i);
+    }
+
+    if (indexer.numPages() == 0)
+    {
+        return entry;
+    }
+
+    QImage cover;
+
+    // A pack's first page only needs shrinking
+    if (archive.type() == Archive::Pack)
+    {
+        const PackFile &pack = archive.pack();
+        entry.pageSize = pack.fullSize(0);
+        cover = pack.page(0).scaledToHeight(COVER_HEIGHT, Qt::SmoothTransformation);
+    }
+    else
+    {
+        // Extract the first page (which may be in an inner archive)
+        const Archive &source = indexer.pageArchive(0);
+        QByteArray pageName = indexer.pageName(0);
+        QByteArray data = Archive::extract(source.type(), source.filename(),
+            source.programPath(), pageName, EXTRACT_WAIT);
+        QBuffer buffer(&data);
+
+        // Decode it straight to cover size (JPEG decodes a lot faster this way)
+        QImageReader reader(&buffer, QFileInfo(pageName).suffix().toLower().toLatin1());
+        entry.pageSize = reader.size();
+
+        if (entry.pageSize.isValid())
+        {
+            reader.setScaledSize(entry.pageSize.scaled(
+                entry.pageSize.width() * COVER_HEIGHT, COVER_HEIGHT,
+                Qt::KeepAspectRatio));
+        }
+
+        cover = reader.read();
+
+        if (cover.isNull())
+        {
+            debug()<<"Cover unreadable"<<entry.path<<reader.errorString();
+            return entry;
+        }
+
+        entry.pageSize = entry.pageSize.isValid() ? entry.pageSize : cover.size();
+    }
+
+    // Covers are named by identity, so a changed archive gets a new one
+    entry.cover = QDir(coverFolder).filePath(QString::fromLatin1(archive.identity()) + ".jpg");
+    cover.save(entry.cover, "JPG");
+
+    return entry;
+}
+
+void Library::removeCover(const Entry &entry)
+{
+    if (!entry.cover.isEmpty())
+    {
+        QFile::remove(entry.cover);
+    }
+}
+
+/**
+ * Whether a path is under one of the folders being scanned (archives
+ * elsewhere stay in the index).
+ */
+bool Library::isUnder(const QString &path) const
+{
+    foreach (const QString &root, _roots)
+    {
+        if (path.startsWith(root + '/'))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Library::load()
+{
+    QFile file(_location.filePath("library.index"));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic;
+    qint32 version;
+    qint32 count;
+    stream>>magic>>version>>count;
+
+    // Start over with an old or foreign index
+    if (magic != MAGIC || version != VERSION)
+    {
+        debug()<<"Ignoring library index"<<file.fileName();
+        return;
+    }
+
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        Entry entry;
+        qint32 numPages;
+        stream>>entry.path>>entry.size>>entry.modified
+            >>numPages>>entry.bytes>>entry.pageSize>>entry.cover;
+        entry.numPages = numPages;
+
+        if (stream.status() == QDataStream::Ok)
+        {
+            _entries[entry.path] = entry;
+        }
+    }
+}
+
+void Library::save()
+{
+    QSaveFile file(_location.filePath("library.index"));
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        debug()<<"Can't save library index"<<file.fileName();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream<<MAGIC<<VERSION<<qint32(_entries.size());
+
+    foreach (const Entry &entry, _entries)
+    {
+        stream<<entry.path<<entry.size<<entry.modified
+            <<qint32(entry.numPages)<<entry.bytes<<entry.pageSize<<entry.cover;
+    }
+
+    file.commit();
+    _unsaved = 0;
+}
@@ -0,0 +1,100 @@
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <QObject>
+
+#include <QDir>
+#include <QFutureWatcher>
+#include <QMap>
+#include <QSize>
+#include <QStringList>
+#include <QTime>
+
+/**
+ * @brief An on-disk index of every archive under a set of folders.
+ *
+ * Scanning walks the folders in parallel, then lists each new or changed
+ * archive (judged by size and modification time) on the thread pool,
+ * recording its page count, total size, and the size of its first page, and
+ * saving a small cover. Unchanged archives only cost a stat, so rescanning a
+ * large library is quick. The index is saved as results come in, so an
+ * interrupted first scan isn't lost.
+ */
+class Library : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry
+    {
+        QString path;
+        qint64 size;
+        qint64 modified;
+
+        int numPages;
+        qint64 bytes;
+        QSize pageSize;
+        QString cover;
+    };
+
+public:
+    Library(const QString &location = QString(), QObject *parent = NULL);
+    ~Library();
+
+    void scan(const QStringList &roots);
+    bool isScanning() const;
+
+    QList<Entry> entries() const;
+    int numExamined() const;
+
+signals:
+    void progress(int done, int total);
+    void scanned();
+
+private slots:
+    void walkFinished();
+    void entryExamined(int index);
+    void examineProgress(int done);
+    void examineFinished();
+
+private:
+    /** Lists one archive and saves its cover, on the thread pool */
+    struct Examiner
+    {
+        typedef Entry result_type;
+
+        QString coverFolder;
+
+        Entry operator()(const Entry &found) const;
+    };
+
+private:
+    static QList<Entry> walk(const QString &directory);
+    static Entry stat(const QFileInfo &info);
+    void removeCover(const Entry &entry);
+    bool isUnder(const QString &path) const;
+    void load();
+    void save();
+
+private:
+    static const quint32 MAGIC;
+    static const qint32 VERSION;
+    static const int COVER_HEIGHT;
+    static const int EXTRACT_WAIT;
+    static const int SAVE_INTERVAL;
+
+private:
+    QDir _location;
+    QMap<QString, Entry> _entries;
+
+    QStringList _roots;
+    QList<Entry> _rootFiles;
+    QFutureWatcher<QList<Entry> > _walk;
+    QFutureWatcher<Entry> _examine;
+    int _numExamined;
+    int _unsaved;
+    QTime _scanTime;
+    qint64 _traceId;
+};
+
+#endif
@@ -65,8 +65,12 @@ LoadingSprite::LoadingSprite(QColor foreground, QColor background)
     painter.setPen(QPen(foreground, double(TILE_SIZE) * LINE_WIDTH));
 
     painter.drawLines(points);
+    painter.end();
 
-    _clock.start();
+    // Repeat it with a brush
+    _brush = QBrush(_tile);
+
+    _time = 0;
 }
 
 LoadingSprite::~LoadingSprite()
@@ -78,33 +82,28 @@ void LoadingSprite::setGeometry(const QRect &rect)
     _rect = rect;
 }
 
+/**
+ * Set the animation time, in milliseconds.
+ */
+void LoadingSprite::setTime(qint64 time)
+{
+    _time = time;
+}
+
 void LoadingSprite::paint(QPainter *painter, const QRect &updateRect)
 {
     QRect paintRect = _rect & updateRect;
 
-    int minx = (paintRect.left() + TILE_SIZE - 1) / TILE_SIZE - 1;
-    int miny = (paintRect.top() + TILE_SIZE - 1) / TILE_SIZE - 2;
-    int maxx = (paintRect.right() + TILE_SIZE - 1) / TILE_SIZE;
-    int maxy = (paintRect.bottom() + TILE_SIZE - 1) / TILE_SIZE + 1;
-
-    int offset = int(double(_clock.elapsed()) * SPEED + 0.5) % TILE_SIZE;
-
-    QRect fullSource(0, 0, TILE_SIZE, TILE_SIZE);
-    QRect source;
-    QPoint topLeft;
-
-    for (int y = miny; y < maxy; y++)
+    if (paintRect.isEmpty())
     {
-        for (int x = minx; x < maxx; x++)
-        {
-            topLeft = QPoint(x * TILE_SIZE, y * TILE_SIZE + offset);
-            source = fullSource & paintRect.translated(-topLeft);
-
-            if (!source.isEmpty())
-            {
-                topLeft += source.topLeft();
-                painter->drawPixmap(topLeft, _tile, source);
-            }
-        }
+        return;
     }
+
+    int offset = int(double(_time) * SPEED + 0.5) % TILE_SIZE;
+
+    // Slide the texture down and fill
+    QPointF origin = painter->brushOrigin();
+    painter->setBrushOrigin(0, offset);
+    painter->fillRect(paintRect, _brush);
+    painter->setBrushOrigin(origin);
 }
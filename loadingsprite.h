@@ -1,11 +1,17 @@
 #ifndef LOADINGSPRITE_H
 #define LOADINGSPRITE_H
 
-#include <QTime>
+#include <QBrush>
 #include <QPixmap>
 
 class QPainter;
 
+/**
+ * @brief Scrolling stripes shown where a page is loading.
+ *
+ * The stripe tile is held in a texture brush, so a frame is a single fill of
+ * the loading rect with the brush origin moved along.
+ */
 class LoadingSprite
 {
 public:
@@ -13,14 +19,16 @@ public:
     ~LoadingSprite();
 
     void setGeometry(const QRect &rect);
+    void setTime(qint64 time);
     void paint(QPainter *painter, const QRect &updateRect);
 
 private:
     static const int TILE_SIZE;
     static const double LINE_WIDTH;
     static const double SPEED;
-    QTime _clock;
+    qint64 _time;
     QPixmap _tile;
+    QBrush _brush;
     QRect _rect;
 };
 
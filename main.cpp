@@ -3,11 +3,95 @@
 #include <QSettings>
 
 #include <QProcess>
+#include <QDir>
 #include <QFile>
 #include <QTextCodec>
+#include <QTextStream>
+#include <QTime>
 
 #include "mainwindow.h"
 #include "debug.h"
+#include "instance.h"
+#include "library.h"
+#include "packexporter.h"
+#include "trace.h"
+
+/**
+ * Scan the given folders into the library index.
+ */
+static int scanLibrary(const QStringList &roots)
+{
+    QTextStream out(stdout);
+
+    if (roots.isEmpty())
+    {
+        out<<"Usage: yomikata --scan-library FOLDER...\n";
+        return 1;
+    }
+
+    Library library;
+    QTime clock;
+    clock.start();
+
+    QObject::connect(&library, SIGNAL(scanned()), qApp, SLOT(quit()));
+    library.scan(roots);
+    qApp->exec();
+
+    out<<library.entries().size()<<" archives, "
+        <<library.numExamined()<<" listed, "
+        <<clock.elapsed()<<" ms\n";
+
+    Trace::write();
+    return 0;
+}
+
+/**
+ * Write a book as a reading pack for one view size.
+ */
+static int exportPack(const QStringList &args)
+{
+    QTextStream out(stdout);
+    QSize viewSize(1920, 1080);
+    QStringList filenames;
+
+    for (int i = 0; i < args.size(); i++)
+    {
+        if (args[i] == "--size" && i + 1 < args.size())
+        {
+            QStringList size = args[++i].split('x');
+            if (size.size() == 2)
+            {
+                viewSize = QSize(size[0].toInt(), size[1].toInt());
+            }
+        }
+        else
+        {
+            filenames<<args[i];
+        }
+    }
+
+    if (filenames.size() != 2 || viewSize.isEmpty())
+    {
+        out<<"Usage: yomikata --export-pack [--size WxH] ARCHIVE PACK\n";
+        return 1;
+    }
+
+    PackExporter exporter(viewSize);
+    QTime clock;
+    clock.start();
+
+    if (!exporter.write(filenames[0], filenames[1]))
+    {
+        out<<exporter.errorString()<<"\n";
+        return 1;
+    }
+
+    out<<exporter.numPages()<<" pages, "
+        <<clock.elapsed()<<" ms\n";
+
+    Trace::write();
+    return 0;
+}
 
 #ifndef UNIT_TESTING
 int main(int argc, char *argv[])
@@ -39,9 +123,53 @@ int application_main(int argc, char *argv[])
         arg = QCoreApplication::arguments()[1];
     }
 
+    // Update the library index without opening a window
+    if (arg == "--scan-library")
+    {
+        return scanLibrary(QCoreApplication::arguments().mid(2));
+    }
+
+    // Or write a reading pack
+    if (arg == "--export-pack")
+    {
+        return exportPack(QCoreApplication::arguments().mid(2));
+    }
+
+    // Skip the running instance if asked
+    bool newInstance = (arg == "--new-instance");
+
+    if (newInstance)
+    {
+        arg = QCoreApplication::arguments().value(2);
+    }
+
+    // Otherwise hand the file to it, if it's there and answers
+    Instance instance;
+
+    if (!newInstance)
+    {
+        Instance::ForwardResult forwarded =
+            instance.forward(arg.isEmpty() ? arg : QDir::current().absoluteFilePath(arg));
+
+        if (forwarded == Instance::Forwarded)
+        {
+            return 0;
+        }
+
+        instance.listen(forwarded);
+    }
+
     // Qt doesn't destory main windows automatically
     MainWindow window(arg);
     window.show();
 
-    return app.exec();
+    QObject::connect(&instance, SIGNAL(fileRequested(const QString &)),
+        &window, SLOT(openFile(const QString &)));
+
+    int result = app.exec();
+
+    // Save the timeline, if tracing
+    Trace::write();
+
+    return result;
 }
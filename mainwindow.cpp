@@ -8,10 +8,13 @@
 #include <QFileDialog>
 #include <QWheelEvent>
 #include <QMouseEvent>
+#include <QStackedWidget>
 #include <QTime>
 
 #include "debug.h"
 #include "steward.h"
+#include "thumbnailmodel.h"
+#include "thumbnailview.h"
 #include "toolbarwidget.h"
 #include "viewwidget.h"
 
@@ -28,14 +31,24 @@ MainWindow::MainWindow(const QString &initialArg, QWidget *parent)
     layout->setContentsMargins(0, 0, 0, 0);
     layout->setSpacing(0);
 
+    // Thumbnails, shared by the strip and the overview
+    ThumbnailModel *thumbnails = new ThumbnailModel(*_steward, this);
+
     // Add the toolbar
-    ToolbarWidget *toolbar = new ToolbarWidget(*_steward, this);
+    ToolbarWidget *toolbar = new ToolbarWidget(*_steward, thumbnails, this);
     toolbar->hide();
     layout->addWidget(toolbar);
 
-    // Add the view widget
-    ViewWidget *view = new ViewWidget(*_steward, toolbar, this);
-    layout->addWidget(view);
+    // Add the view widget, with the overview in its place when shown
+    _pages = new QStackedWidget(this);
+    layout->addWidget(_pages);
+
+    _view = new ViewWidget(*_steward, toolbar, this);
+    _pages->addWidget(_view);
+
+    _overview = new ThumbnailView(*_steward, thumbnails, ThumbnailView::Grid, this);
+    _pages->addWidget(_overview);
+    connect(_overview, SIGNAL(pageChosen(int)), SLOT(showReading()));
 
     // Enable things
     _zoomToggleEnabled = true;
@@ -51,14 +64,7 @@ MainWindow::MainWindow(const QString &initialArg, QWidget *parent)
     if (!initialArg.isEmpty())
     {
         // Open the file right away
-        if (QDir::isRelativePath(initialArg))
-        {
-            setSource(QDir::current().absoluteFilePath(initialArg));
-        }
-        else
-        {
-            setSource(initialArg);
-        }
+        setSource(QDir::current().absoluteFilePath(initialArg));
     }
 
     // Open shortcut
@@ -68,6 +74,13 @@ MainWindow::MainWindow(const QString &initialArg, QWidget *parent)
     addAction(open);
     connect(open, SIGNAL(triggered()), SLOT(open()));
 
+    // Open folder shortcut
+    QAction *openFolder = new QAction(this);
+    openFolder->setShortcut(Qt::SHIFT + Qt::Key_O);
+    openFolder->setShortcutContext(Qt::ApplicationShortcut);
+    addAction(openFolder);
+    connect(openFolder, SIGNAL(triggered()), SLOT(openFolder()));
+
     // Fullscreen shortcut
     QAction *fullscreen = new QAction(this);
     fullscreen->setCheckable(true);
@@ -76,6 +89,20 @@ MainWindow::MainWindow(const QString &initialArg, QWidget *parent)
     addAction(fullscreen);
     connect(fullscreen, SIGNAL(toggled(bool)), SLOT(fullscreen(bool)));
 
+    // Debug shortcut
+    QAction *debugPanel = new QAction(this);
+    debugPanel->setShortcut(Qt::Key_D);
+    debugPanel->setShortcutContext(Qt::ApplicationShortcut);
+    addAction(debugPanel);
+    connect(debugPanel, SIGNAL(triggered()), SLOT(toggleDebug()));
+
+    // Overview shortcut
+    QAction *overview = new QAction(this);
+    overview->setShortcut(Qt::Key_G);
+    overview->setShortcutContext(Qt::ApplicationShortcut);
+    addAction(overview);
+    connect(overview, SIGNAL(triggered()), SLOT(toggleOverview()));
+
     // Quit shortcut
     QAction *quit = new QAction(this);
     quit->setShortcut(Qt::Key_Q);
@@ -204,6 +231,34 @@ void MainWindow::open()
     }
 }
 
+/**
+ * A folder of images is read as a book.
+ */
+void MainWindow::openFolder()
+{
+    QString folder = QFileDialog::getExistingDirectory(this, "Open Folder");
+
+    if (!folder.isEmpty())
+    {
+        setSource(folder);
+    }
+}
+
+/**
+ * Open a file sent from another instance, and come to the front.
+ */
+void MainWindow::openFile(const QString &filename)
+{
+    if (!filename.isEmpty())
+    {
+        setSource(filename);
+    }
+
+    setWindowState(windowState() & ~Qt::WindowMinimized);
+    raise();
+    activateWindow();
+}
+
 void MainWindow::fullscreen(bool toggled)
 {
     if (toggled)
@@ -215,3 +270,27 @@ void MainWindow::fullscreen(bool toggled)
         showNormal();
     }
 }
+
+void MainWindow::toggleDebug()
+{
+    QWidget *debugPanel = _steward->debugWidget();
+    debugPanel->setVisible(!debugPanel->isVisible());
+}
+
+void MainWindow::toggleOverview()
+{
+    if (_pages->currentWidget() == _overview)
+    {
+        showReading();
+    }
+    else
+    {
+        _pages->setCurrentWidget(_overview);
+        _overview->setFocus();
+    }
+}
+
+void MainWindow::showReading()
+{
+    _pages->setCurrentWidget(_view);
+}
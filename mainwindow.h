@@ -5,7 +5,11 @@
 
 #include "book.h"
 
+class QStackedWidget;
+
 class Steward;
+class ThumbnailView;
+class ViewWidget;
 
 class MainWindow: public QMainWindow
 {
@@ -17,6 +21,9 @@ public:
 
     QSize sizeHint() const;
 
+public slots:
+    void openFile(const QString &filename);
+
 signals:
     void nextPage();
     void previousPage();
@@ -27,7 +34,11 @@ protected:
 
 protected slots:
     void open();
+    void openFolder();
     void fullscreen(bool toggled);
+    void toggleDebug();
+    void toggleOverview();
+    void showReading();
 
 private:
     void wheelEvent(QWheelEvent *event);
@@ -35,6 +46,9 @@ private:
 
 private:
     Steward *_steward;
+    QStackedWidget *_pages;
+    ViewWidget *_view;
+    ThumbnailView *_overview;
     bool _zoomToggleEnabled;
     bool _zoomInEnabled;
     bool _zoomOutEnabled;
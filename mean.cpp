@@ -1,12 +1,11 @@
 #include "mean.h"
 
-#include <QDebug>
-
 Mean::Mean(int saturation, int restart)
 {
     _saturation = saturation;
     _restart = restart;
     _samples = _restart - 1;
+    _mean = 0.0;
 }
 
 Mean::~Mean()
@@ -21,7 +20,6 @@ void Mean::addSample(double value)
     {
         _mean = value;
         _samples = 1;
-        qDebug()<<"FPS"<<1000.0 / _mean;
     }
     else if (_samples < _saturation)
     {
@@ -0,0 +1,128 @@
+#include "naturalorder.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#include "archive.h"
+#include "fileclassification.h"
+
+bool NaturalOrder::lessThan(const QString &a, const QString &b)
+{
+    int result = compare(a, b);
+
+    // Fall back on an exact comparison, so the order is total
+    return result != 0 ? result < 0 : a < b;
+}
+
+void NaturalOrder::sort(QStringList &names)
+{
+    std::sort(names.begin(), names.end(), &NaturalOrder::lessThan);
+}
+
+/**
+ * The archive after @a filename in the same folder, or an empty string if
+ * it's the last one. Archives that @a archive can't read (having no program
+ * for them) are passed over.
+ */
+QString NaturalOrder::nextFile(const QString &filename, const Archive *archive)
+{
+    QFileInfo info(filename);
+    QDir dir = info.dir();
+
+    // Find the neighbouring archives
+    QStringList archives;
+
+    foreach (const QString &name, dir.entryList(QDir::Files))
+    {
+        if (FileClassification::isArchiveFile(name))
+        {
+            archives<<name;
+        }
+    }
+
+    sort(archives);
+
+    int index = archives.indexOf(info.fileName());
+
+    if (index == -1)
+    {
+        return QString();
+    }
+
+    for (int i = index + 1; i < archives.size(); i++)
+    {
+        if (archive->typeOf(archives[i]) != Archive::InvalidArchiveType)
+        {
+            return dir.absoluteFilePath(archives[i]);
+        }
+    }
+
+    return QString();
+}
+
+int NaturalOrder::compare(const QString &a, const QString &b)
+{
+    int i = 0;
+    int j = 0;
+
+    while (i < a.length() && j < b.length())
+    {
+        if (a[i].isDigit() && b[j].isDigit())
+        {
+            // Skip leading zeros
+            while (i < a.length() && a[i] == '0')
+            {
+                i++;
+            }
+            while (j < b.length() && b[j] == '0')
+            {
+                j++;
+            }
+
+            // Measure the numbers
+            int startA = i;
+            int startB = j;
+
+            while (i < a.length() && a[i].isDigit())
+            {
+                i++;
+            }
+            while (j < b.length() && b[j].isDigit())
+            {
+                j++;
+            }
+
+            // A longer number is bigger; otherwise the first different digit
+            // decides
+            if (i - startA != j - startB)
+            {
+                return (i - startA) - (j - startB);
+            }
+
+            int digits = a.midRef(startA, i - startA).compare(b.midRef(startB, j - startB));
+
+            if (digits != 0)
+            {
+                return digits;
+            }
+        }
+        else
+        {
+            QChar charA = a[i].toCaseFolded();
+            QChar charB = b[j].toCaseFolded();
+
+            if (charA != charB)
+            {
+                return charA.unicode() - charB.unicode();
+            }
+
+            i++;
+            j++;
+        }
+    }
+
+    // The shorter one (what's left of it) comes first
+    return (a.length() - i) - (b.length() - j);
+}
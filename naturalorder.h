@@ -0,0 +1,31 @@
+#ifndef NATURALORDER_H
+#define NATURALORDER_H
+
+#include <QString>
+#include <QStringList>
+
+class Archive;
+
+/**
+ * @brief Orders file names the way people number them, so "vol 9" comes
+ * before "vol 10".
+ *
+ * Runs of digits compare by value, and everything else compares without
+ * case. QCollator's numeric mode needs ICU, which isn't always there, so
+ * this is done by hand.
+ */
+class NaturalOrder
+{
+public:
+    static bool lessThan(const QString &a, const QString &b);
+    static void sort(QStringList &names);
+    static QString nextFile(const QString &filename, const Archive *archive);
+
+private:
+    static int compare(const QString &a, const QString &b);
+
+private:
+    NaturalOrder();
+};
+
+#endif
@@ -0,0 +1,294 @@
+#include "packedimage.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+using std::fill;
+using std::max;
+using std::min;
+
+namespace
+{
+    // Each token is a 16-bit header (the kind in the top two bits and the
+    // length below), followed by the pixel for a run, the pixels of a
+    // literal, or the distance (one byte) for a repeat of a short pattern
+    // like a screentone
+    enum Kind
+    {
+        Literal = 0,
+        Run,
+        Above,
+        Repeat
+    };
+
+    inline void putHeader(QByteArray *out, Kind kind, int length)
+    {
+        quint16 header = quint16((kind << 14) | (length - 1));
+        out->append(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+}
+
+const int PackedImage::MIN_MATCH = 4;
+const int PackedImage::MAX_LENGTH = 1 << 14;
+const int PackedImage::MAX_REPEAT_DISTANCE = 8;
+
+PackedImage::PackedImage()
+{
+    _format = QImage::Format_Invalid;
+    _unpackedBytes = 0;
+}
+
+PackedImage::~PackedImage()
+{
+}
+
+PackedImage PackedImage::pack(const QImage &image)
+{
+    PackedImage packed;
+    packed._size = image.size();
+    packed._format = image.format();
+    packed._unpackedBytes = image.byteCount();
+
+    // Pick the pixel size
+    int depth;
+
+    switch (image.format())
+    {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        depth = 4;
+        break;
+    case QImage::Format_Grayscale8:
+        depth = 1;
+        break;
+    default:
+        depth = 0;
+        break;
+    }
+
+    // Keep other formats as they are
+    if (depth == 0)
+    {
+        packed._unpacked = image;
+        return packed;
+    }
+
+    // Flat pages pack very small, so only reserve a little
+    packed._data.reserve(image.byteCount() / 8);
+
+    for (int y = 0; y < image.height(); y++)
+    {
+        if (depth == 4)
+        {
+            packRow(reinterpret_cast<const quint32 *>(image.constScanLine(y)),
+                y > 0 ? reinterpret_cast<const quint32 *>(image.constScanLine(y - 1)) : NULL,
+                image.width(), &packed._data);
+        }
+        else
+        {
+            packRow(image.constScanLine(y), y > 0 ? image.constScanLine(y - 1) : NULL,
+                image.width(), &packed._data);
+        }
+    }
+
+    packed._data.squeeze();
+    return packed;
+}
+
+QImage PackedImage::unpack() const
+{
+    if (isNull() || !_unpacked.isNull())
+    {
+        return _unpacked;
+    }
+
+    QImage image(_size, _format);
+    const char *in = _data.constData();
+
+    for (int y = 0; y < image.height(); y++)
+    {
+        if (_format == QImage::Format_Grayscale8)
+        {
+            in = unpackRow(in, image.scanLine(y), y > 0 ? image.constScanLine(y - 1) : NULL,
+                image.width());
+        }
+        else
+        {
+            in = unpackRow(in, reinterpret_cast<quint32 *>(image.scanLine(y)),
+                y > 0 ? reinterpret_cast<const quint32 *>(image.constScanLine(y - 1)) : NULL,
+                image.width());
+        }
+    }
+
+    Q_ASSERT(in == _data.constData() + _data.size());
+    return image;
+}
+
+bool PackedImage::isNull() const
+{
+    return _format == QImage::Format_Invalid;
+}
+
+qint64 PackedImage::packedBytes() const
+{
+    return _unpacked.isNull() ? _data.size() : _unpacked.byteCount();
+}
+
+qint64 PackedImage::unpackedBytes() const
+{
+    return _unpackedBytes;
+}
+
+/**
+ * Greedy: take the longest run, copy of the row above, or repeat when one is
+ * long enough, otherwise grow a literal.
+ */
+template <typename Pixel>
+void PackedImage::packRow(const Pixel *row, const Pixel *above, int width, QByteArray *out)
+{
+    int literalStart = 0;
+    int x = 0;
+
+    while (x < width)
+    {
+        int limit = min(width, x + MAX_LENGTH);
+
+        // Measure the matches starting here
+        int run = x + 1;
+        while (run < limit && row[run] == row[x])
+        {
+            run++;
+        }
+        run -= x;
+
+        int copy = 0;
+        if (above != NULL)
+        {
+            while (x + copy < limit && row[x + copy] == above[x + copy])
+            {
+                copy++;
+            }
+        }
+
+        int repeat = 0;
+        int distance = 0;
+        for (int d = 2; d <= MAX_REPEAT_DISTANCE && d <= x; d++)
+        {
+            int length = 0;
+            while (x + length < limit && row[x + length] == row[x + length - d])
+            {
+                length++;
+            }
+
+            if (length > repeat)
+            {
+                repeat = length;
+                distance = d;
+            }
+        }
+
+        int best = max(run, max(copy, repeat));
+
+        if (best < MIN_MATCH)
+        {
+            x++;
+
+            // Don't let a literal get too long
+            if (x - literalStart < MAX_LENGTH)
+            {
+                continue;
+            }
+        }
+
+        // Finish any literal before here
+        if (x > literalStart)
+        {
+            putHeader(out, Literal, x - literalStart);
+            out->append(reinterpret_cast<const char *>(row + literalStart), (x - literalStart) * sizeof(Pixel));
+        }
+
+        if (best >= MIN_MATCH)
+        {
+            // Prefer copies, as they need no pixel
+            if (copy == best)
+            {
+                putHeader(out, Above, copy);
+            }
+            else if (run == best)
+            {
+                putHeader(out, Run, run);
+                out->append(reinterpret_cast<const char *>(row + x), sizeof(Pixel));
+            }
+            else
+            {
+                putHeader(out, Repeat, repeat);
+                out->append(char(distance));
+            }
+
+            x += best;
+        }
+
+        literalStart = x;
+    }
+
+    // Trailing literal
+    if (x > literalStart)
+    {
+        putHeader(out, Literal, x - literalStart);
+        out->append(reinterpret_cast<const char *>(row + literalStart), (x - literalStart) * sizeof(Pixel));
+    }
+}
+
+template <typename Pixel>
+const char *PackedImage::unpackRow(const char *in, Pixel *row, const Pixel *above, int width)
+{
+    int x = 0;
+
+    while (x < width)
+    {
+        quint16 header;
+        memcpy(&header, in, sizeof(header));
+        in += sizeof(header);
+
+        Kind kind = Kind(header >> 14);
+        int length = (header & (MAX_LENGTH - 1)) + 1;
+        Q_ASSERT(x + length <= width);
+
+        switch (kind)
+        {
+        case Literal:
+            memcpy(row + x, in, length * sizeof(Pixel));
+            in += length * sizeof(Pixel);
+            break;
+        case Run:
+            {
+                Pixel pixel;
+                memcpy(&pixel, in, sizeof(Pixel));
+                in += sizeof(Pixel);
+                fill(row + x, row + x + length, pixel);
+            }
+            break;
+        case Above:
+            Q_ASSERT(above != NULL);
+            memcpy(row + x, above + x, length * sizeof(Pixel));
+            break;
+        case Repeat:
+            {
+                // Overlapping, so one pixel at a time
+                int distance = quint8(*in);
+                in++;
+                for (int i = x; i < x + length; i++)
+                {
+                    row[i] = row[i - distance];
+                }
+            }
+            break;
+        }
+
+        x += length;
+    }
+
+    return in;
+}
@@ -0,0 +1,51 @@
+#ifndef PACKEDIMAGE_H
+#define PACKEDIMAGE_H
+
+#include <QByteArray>
+#include <QImage>
+
+/**
+ * @brief An image compressed for keeping in memory.
+ *
+ * Scanned and drawn pages are mostly flat areas, repeated lines and
+ * screentones, so each row is coded as runs of one pixel, copies of the row
+ * above, repeats of a short pattern, and literal pixels. Unpacking is little
+ * more than fills and copies, so it's much faster than decoding the page
+ * again.
+ *
+ * 32-bit and 8-bit grey images are packed; other formats are kept as they
+ * are.
+ */
+class PackedImage
+{
+public:
+    PackedImage();
+    ~PackedImage();
+
+    static PackedImage pack(const QImage &image);
+    QImage unpack() const;
+
+    bool isNull() const;
+    qint64 packedBytes() const;
+    qint64 unpackedBytes() const;
+
+private:
+    template <typename Pixel>
+    static void packRow(const Pixel *row, const Pixel *above, int width, QByteArray *out);
+    template <typename Pixel>
+    static const char *unpackRow(const char *in, Pixel *row, const Pixel *above, int width);
+
+private:
+    static const int MIN_MATCH;
+    static const int MAX_LENGTH;
+    static const int MAX_REPEAT_DISTANCE;
+
+private:
+    QByteArray _data;
+    QImage _unpacked;
+    QSize _size;
+    QImage::Format _format;
+    qint64 _unpackedBytes;
+};
+
+#endif
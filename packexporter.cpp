@@ -0,0 +1,263 @@
+#include "packexporter.h"
+
+#include <QBuffer>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <string.h>
+
+#include <vector>
+
+#include "book.h"
+#include "debug.h"
+#include "indexer.h"
+#include "packfile.h"
+#include "projector.h"
+#include "strategist.h"
+#include "trace.h"
+
+using std::vector;
+
+const int PackExporter::EXTRACT_WAIT = 30000;
+
+PackExporter::PackExporter(const QSize &viewSize)
+    : _viewSize(viewSize)
+{
+    _numPages = 0;
+}
+
+PackExporter::~PackExporter()
+{
+}
+
+/**
+ * Blocks until the pack is written. On failure, nothing is left at
+ * @a packFilename and errorString() says why.
+ */
+bool PackExporter::write(const QString &filename, const QString &packFilename)
+{
+    TraceScope scope("export");
+    _numPages = 0;
+    _errorString.clear();
+
+    // List the book
+    Archive archive;
+
+    if (!archive.reset(filename) || archive.type() == Archive::Pack)
+    {
+        _errorString = "Can't read " + filename;
+        return false;
+    }
+
+    Indexer indexer(archive);
+    indexer.build();
+
+    if (indexer.numPages() == 0)
+    {
+        _errorString = "No pages in " + filename;
+        return false;
+    }
+
+    // (Copied, as the archives can't be shared with the thread pool)
+    QList<Page> pages;
+
+    for (int i = 0; i < indexer.numPages(); i++)
+    {
+        const Archive &source = indexer.pageArchive(i);
+
+        Page page;
+        page.type = source.type();
+        page.filename = source.filename();
+        page.programPath = source.programPath();
+        page.name = indexer.pageName(i);
+        pages<<page;
+    }
+
+    // Measure every page
+    QList<QSize> fullSizes = QtConcurrent::blockingMapped(pages, &PackExporter::measure);
+    QMap<int, QSize> sizes;
+
+    for (int i = 0; i < fullSizes.size(); i++)
+    {
+        if (!fullSizes[i].isValid())
+        {
+            _errorString = "Can't read page " + QString::fromLocal8Bit(pages[i].name);
+            return false;
+        }
+
+        sizes[i] = fullSizes[i];
+    }
+
+    // Lay the pages out like the steward will
+    Book book;
+    book.reset(pages.size());
+
+    Strategist strategist(book);
+    strategist.reset();
+    strategist.setViewport(Projector::magnifiedSize(_viewSize), _viewSize);
+    strategist.restoreFullPageSizes(sizes);
+
+    vector<PackFile::Entry> entries(pages.size());
+
+    for (int i = 0; i < pages.size(); i++)
+    {
+        pages[i].size = strategist.pageLayout(i).size();
+
+        memset(&entries[i], 0, sizeof(PackFile::Entry));
+        entries[i].fullWidth = fullSizes[i].width();
+        entries[i].fullHeight = fullSizes[i].height();
+        entries[i].flags = book.isDual(i) ? PackFile::DualFlag : 0;
+    }
+
+    // Write the header, and leave room for the table
+    QSaveFile file(packFilename);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        _errorString = "Can't write " + packFilename;
+        return false;
+    }
+
+    PackFile::Header header;
+    memset(&header, 0, sizeof(PackFile::Header));
+    memcpy(header.magic, PackFile::MAGIC, sizeof(header.magic));
+    header.version = PackFile::VERSION;
+    header.viewWidth = _viewSize.width();
+    header.viewHeight = _viewSize.height();
+    header.numPages = pages.size();
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(PackFile::Header));
+    file.write(QByteArray(pages.size() * sizeof(PackFile::Entry), '\0'));
+
+    // Decode a few pages at a time (so the whole book is never in memory),
+    // writing each one out aligned
+    int chunk = QThread::idealThreadCount() * 2;
+
+    for (int first = 0; first < pages.size(); first += chunk)
+    {
+        QList<QImage> images = QtConcurrent::blockingMapped(pages.mid(first, chunk), &PackExporter::render);
+
+        for (int i = 0; i < images.size(); i++)
+        {
+            PackFile::Entry &entry = entries[first + i];
+            const QImage &image = images[i];
+
+            if (image.isNull())
+            {
+                _errorString = "Can't decode page " + QString::fromLocal8Bit(pages[first + i].name);
+                file.cancelWriting();
+                return false;
+            }
+
+            qint64 offset = align(file.pos());
+            file.write(QByteArray(offset - file.pos(), '\0'));
+
+            entry.offset = offset;
+            entry.width = image.width();
+            entry.height = image.height();
+            entry.bytesPerLine = image.bytesPerLine();
+            entry.format = image.format();
+
+            file.write(reinterpret_cast<const char *>(image.constBits()),
+                qint64(image.bytesPerLine()) * image.height());
+        }
+    }
+
+    // Fill in the table
+    file.seek(sizeof(PackFile::Header));
+    file.write(reinterpret_cast<const char *>(&entries[0]), entries.size() * sizeof(PackFile::Entry));
+
+    if (!file.commit())
+    {
+        _errorString = "Can't write " + packFilename;
+        return false;
+    }
+
+    _numPages = pages.size();
+    return true;
+}
+
+int PackExporter::numPages() const
+{
+    return _numPages;
+}
+
+const QString &PackExporter::errorString() const
+{
+    return _errorString;
+}
+
+/**
+ * Runs on the thread pool.
+ */
+QSize PackExporter::measure(const Page &page)
+{
+    TraceScope scope("measure");
+    QByteArray data = Archive::extract(page.type, page.filename, page.programPath,
+        page.name, EXTRACT_WAIT);
+    QBuffer buffer(&data);
+
+    // The header is usually enough, otherwise the whole page is read
+    QImageReader reader(&buffer, QFileInfo(page.name).suffix().toLower().toLatin1());
+    QSize size = reader.size();
+
+    if (!size.isValid())
+    {
+        size = reader.read().size();
+    }
+
+    return size;
+}
+
+/**
+ * Runs on the thread pool.
+ */
+QImage PackExporter::render(const Page &page)
+{
+    TraceScope scope("render");
+    return read(page);
+}
+
+/**
+ * Decode at the shown size the same way the decoders do, then keep only the
+ * formats a pack can map.
+ */
+QImage PackExporter::read(const Page &page)
+{
+    QByteArray data = Archive::extract(page.type, page.filename, page.programPath,
+        page.name, EXTRACT_WAIT);
+    QBuffer buffer(&data);
+
+    QImageReader reader(&buffer, QFileInfo(page.name).suffix().toLower().toLatin1());
+    QSize size = page.size;
+    reader.setScaledSize(size);
+    QImage image = reader.read();
+
+    if (image.isNull())
+    {
+        debug()<<"Page unreadable"<<page.name<<reader.errorString();
+        return image;
+    }
+
+    // Some formats can't be read at a smaller size
+    if (image.size() != size)
+    {
+        image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    if (!PackFile::isReadableFormat(image.format()))
+    {
+        image = image.convertToFormat(image.hasAlphaChannel() ?
+            QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    }
+
+    return image;
+}
+
+qint64 PackExporter::align(qint64 offset)
+{
+    return (offset + PackFile::ALIGNMENT - 1) / PackFile::ALIGNMENT * PackFile::ALIGNMENT;
+}
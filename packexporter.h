@@ -0,0 +1,57 @@
+#ifndef PACKEXPORTER_H
+#define PACKEXPORTER_H
+
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+#include "archive.h"
+
+/**
+ * @brief Writes a book as a reading pack (see PackFile), laid out for one
+ * view size.
+ *
+ * Every page is measured first (from its header), so the pages can be laid
+ * out exactly as the reader will lay them out, dual pages included. Then the
+ * pages are decoded straight to their shown sizes on the thread pool, a few
+ * at a time, and written out as they come.
+ */
+class PackExporter
+{
+public:
+    PackExporter(const QSize &viewSize);
+    ~PackExporter();
+
+    bool write(const QString &filename, const QString &packFilename);
+
+    int numPages() const;
+    const QString &errorString() const;
+
+private:
+    /** Where one page comes from (the book, or an archive inside it) */
+    struct Page
+    {
+        Archive::Type type;
+        QString filename;
+        QString programPath;
+        QByteArray name;
+        QSize size;
+    };
+
+private:
+    static QSize measure(const Page &page);
+    static QImage render(const Page &page);
+    static QImage read(const Page &page);
+    static qint64 align(qint64 offset);
+
+private:
+    static const int EXTRACT_WAIT;
+
+private:
+    QSize _viewSize;
+    int _numPages;
+    QString _errorString;
+};
+
+#endif
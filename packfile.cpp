@@ -0,0 +1,176 @@
+#include "packfile.h"
+
+#include <QFile>
+
+#include <string.h>
+
+#include "debug.h"
+
+const char PackFile::MAGIC[4] = {'Y', 'K', 'P', 'K'};
+const qint32 PackFile::VERSION = 1;
+const int PackFile::ALIGNMENT = 64;
+
+PackFile::PackFile()
+{
+    _data = NULL;
+    _entries = NULL;
+    memset(&_header, 0, sizeof(Header));
+}
+
+PackFile::~PackFile()
+{
+}
+
+/**
+ * Map a pack, checking that its table fits in the file. Returns false (and
+ * stays closed) if it isn't a pack this version can read.
+ */
+bool PackFile::open(const QString &filename)
+{
+    close();
+
+    QSharedPointer<QFile> file(new QFile(filename));
+
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header)))
+    {
+        return false;
+    }
+
+    const uchar *data = file->map(0, file->size());
+
+    if (data == NULL)
+    {
+        return false;
+    }
+
+    // Check the header
+    Header header;
+    memcpy(&header, data, sizeof(Header));
+
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+        || header.version != VERSION
+        || header.numPages < 0
+        || qint64(sizeof(Header)) + qint64(header.numPages) * qint64(sizeof(Entry)) > file->size())
+    {
+        debug()<<"Not a readable pack"<<filename;
+        return false;
+    }
+
+    // Check the pages
+    const Entry *entries = reinterpret_cast<const Entry *>(data + sizeof(Header));
+
+    for (int i = 0; i < header.numPages; i++)
+    {
+        const Entry &entry = entries[i];
+
+        if (entry.offset < 0 || entry.width <= 0 || entry.height <= 0
+            || entry.fullWidth <= 0 || entry.fullHeight <= 0
+            || !isReadableFormat(QImage::Format(entry.format))
+            || entry.bytesPerLine < entry.width * (entry.format == QImage::Format_Grayscale8 ? 1 : 4)
+            || entry.offset + qint64(entry.bytesPerLine) * entry.height > file->size())
+        {
+            debug()<<"Damaged pack"<<filename<<"page"<<i;
+            return false;
+        }
+    }
+
+    _file = file;
+    _data = data;
+    _header = header;
+    _entries = entries;
+    return true;
+}
+
+/**
+ * Pages already handed out keep the file mapped.
+ */
+void PackFile::close()
+{
+    _file.clear();
+    _data = NULL;
+    _entries = NULL;
+    memset(&_header, 0, sizeof(Header));
+}
+
+/**
+ * Pages are kept in the formats the decoders and disk cache use.
+ */
+bool PackFile::isReadableFormat(QImage::Format format)
+{
+    switch (format)
+    {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_Grayscale8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool PackFile::isOpen() const
+{
+    return _data != NULL;
+}
+
+/**
+ * The view size the pages were scaled for.
+ */
+QSize PackFile::viewSize() const
+{
+    return QSize(_header.viewWidth, _header.viewHeight);
+}
+
+int PackFile::numPages() const
+{
+    return _header.numPages;
+}
+
+QSize PackFile::fullSize(int index) const
+{
+    Q_ASSERT(index >= 0 && index < numPages());
+    return QSize(_entries[index].fullWidth, _entries[index].fullHeight);
+}
+
+QMap<int, QSize> PackFile::fullSizes() const
+{
+    QMap<int, QSize> sizes;
+
+    for (int i = 0; i < numPages(); i++)
+    {
+        sizes[i] = fullSize(i);
+    }
+
+    return sizes;
+}
+
+bool PackFile::isDual(int index) const
+{
+    Q_ASSERT(index >= 0 && index < numPages());
+    return (_entries[index].flags & DualFlag) != 0;
+}
+
+qint64 PackFile::pageBytes(int index) const
+{
+    Q_ASSERT(index >= 0 && index < numPages());
+    return qint64(_entries[index].bytesPerLine) * _entries[index].height;
+}
+
+/**
+ * The page, straight from the mapping (read-only, so it's copied if it's
+ * ever changed).
+ */
+QImage PackFile::page(int index) const
+{
+    Q_ASSERT(index >= 0 && index < numPages());
+    const Entry &entry = _entries[index];
+
+    return QImage(_data + entry.offset, entry.width, entry.height, entry.bytesPerLine,
+        QImage::Format(entry.format), &PackFile::release, new QSharedPointer<QFile>(_file));
+}
+
+void PackFile::release(void *file)
+{
+    delete static_cast<QSharedPointer<QFile> *>(file);
+}
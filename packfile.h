@@ -0,0 +1,86 @@
+#ifndef PACKFILE_H
+#define PACKFILE_H
+
+#include <QImage>
+#include <QMap>
+#include <QSharedPointer>
+#include <QSize>
+
+class QFile;
+
+/**
+ * @brief A reading pack: a book's pages scaled for one view size, stored raw
+ * so they can be mapped and shown without extracting or decoding.
+ *
+ * The file is a header, a table of pages (with each page's size as shown,
+ * its original size, and whether it's a dual page), then the pages'
+ * scanlines, aligned. Numbers are in the machine's byte order, as packs are
+ * made for the machine that reads them. Pages handed out share the mapping,
+ * which stays until the last of them is gone.
+ *
+ * Packs are written by PackExporter.
+ */
+class PackFile
+{
+public:
+    struct Header
+    {
+        char magic[4];
+        qint32 version;
+        qint32 viewWidth;
+        qint32 viewHeight;
+        qint32 numPages;
+        qint32 reserved[3];
+    };
+
+    struct Entry
+    {
+        qint64 offset;
+        qint32 width;
+        qint32 height;
+        qint32 bytesPerLine;
+        qint32 format;
+        qint32 fullWidth;
+        qint32 fullHeight;
+        qint32 flags;
+        qint32 reserved;
+    };
+
+    enum Flags
+    {
+        DualFlag = 1
+    };
+
+    static const char MAGIC[4];
+    static const qint32 VERSION;
+    static const int ALIGNMENT;
+
+public:
+    PackFile();
+    ~PackFile();
+
+    bool open(const QString &filename);
+    void close();
+    bool isOpen() const;
+
+    QSize viewSize() const;
+    int numPages() const;
+    QSize fullSize(int index) const;
+    QMap<int, QSize> fullSizes() const;
+    bool isDual(int index) const;
+    qint64 pageBytes(int index) const;
+    QImage page(int index) const;
+
+    static bool isReadableFormat(QImage::Format format);
+
+private:
+    static void release(void *file);
+
+private:
+    QSharedPointer<QFile> _file;
+    const uchar *_data;
+    Header _header;
+    const Entry *_entries;
+};
+
+#endif
@@ -2,8 +2,16 @@
 
 #include <QPainter>
 
+#include "trace.h"
+
+const int PageSprite::TILE_SIZE = 256;
+const int PageSprite::TILE_MARGIN = 256;
+
 PageSprite::PageSprite()
 {
+    _columns = 0;
+    _rows = 0;
+    _tilesHeld = 0;
 }
 
 
@@ -11,9 +19,17 @@ PageSprite::~PageSprite()
 {
 }
 
-void PageSprite::setPixmap(const QPixmap &pixmap)
+void PageSprite::setImage(const QImage &image, const QSize &size)
 {
-    _pixmap = pixmap;
+    _image = image;
+    _size = size;
+
+    // Start with no tiles converted
+    _columns = (_size.width() + TILE_SIZE - 1) / TILE_SIZE;
+    _rows = (_size.height() + TILE_SIZE - 1) / TILE_SIZE;
+    _tiles.clear();
+    _tiles.resize(_columns * _rows);
+    _tilesHeld = 0;
 }
 
 void PageSprite::setTopLeft(const QPoint &topLeft)
@@ -21,7 +37,113 @@ void PageSprite::setTopLeft(const QPoint &topLeft)
     _topLeft = topLeft;
 }
 
+void PageSprite::setViewport(const QRect &viewport)
+{
+    _viewport = viewport;
+}
+
 void PageSprite::paint(QPainter *painter, const QRect &updateRect)
 {
-    painter->drawPixmap(_topLeft, _pixmap);
+    // Work in page coordinates
+    QRect paintRect = (QRect(_topLeft, _size) & updateRect).translated(-_topLeft);
+
+    if (paintRect.isEmpty())
+    {
+        return;
+    }
+
+    // Blit each tile that intersects the update
+    int minColumn = paintRect.left() / TILE_SIZE;
+    int maxColumn = paintRect.right() / TILE_SIZE;
+    int minRow = paintRect.top() / TILE_SIZE;
+    int maxRow = paintRect.bottom() / TILE_SIZE;
+
+    for (int row = minRow; row <= maxRow; row++)
+    {
+        for (int column = minColumn; column <= maxColumn; column++)
+        {
+            QRect tile = tileRect(column, row);
+            QPixmap &pixmap = _tiles[row * _columns + column];
+
+            // Convert the tile the first time it's needed
+            if (pixmap.isNull())
+            {
+                TraceScope scope("tile");
+                pixmap = QPixmap::fromImage(tileImage(tile));
+                _tilesHeld++;
+            }
+
+            // Only blit the part being updated
+            QRect source = (tile & paintRect).translated(-tile.topLeft());
+            painter->drawPixmap(_topLeft + tile.topLeft() + source.topLeft(), pixmap, source);
+        }
+    }
+
+    // Let go of tiles that have moved away
+    releaseHiddenTiles();
+}
+
+int PageSprite::tilesHeld() const
+{
+    return _tilesHeld;
+}
+
+QRect PageSprite::tileRect(int column, int row) const
+{
+    return QRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE)
+        & QRect(QPoint(0, 0), _size);
+}
+
+QImage PageSprite::tileImage(const QRect &tile) const
+{
+    // Exact size, take the pixels directly
+    if (_image.size() == _size)
+    {
+        return _image.copy(tile);
+    }
+
+    // Otherwise scale the matching part of the image (exactly, so the tiles
+    // meet without seams)
+    double scaleX = double(_image.width()) / double(_size.width());
+    double scaleY = double(_image.height()) / double(_size.height());
+    QRectF source(tile.left() * scaleX, tile.top() * scaleY,
+        tile.width() * scaleX, tile.height() * scaleY);
+
+    QImage scaled(tile.size(), _image.hasAlphaChannel() ?
+        QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    scaled.fill(Qt::transparent);
+
+    QPainter painter(&scaled);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(QRectF(QPointF(0, 0), QSizeF(tile.size())), _image, source);
+
+    return scaled;
+}
+
+void PageSprite::releaseHiddenTiles()
+{
+    // Keep everything without a known viewport
+    if (_viewport.isEmpty())
+    {
+        return;
+    }
+
+    // Tiles near the viewport are kept for scrolling
+    QRect kept = _viewport
+        .adjusted(-TILE_MARGIN, -TILE_MARGIN, TILE_MARGIN, TILE_MARGIN)
+        .translated(-_topLeft);
+
+    for (int row = 0; row < _rows; row++)
+    {
+        for (int column = 0; column < _columns; column++)
+        {
+            QPixmap &pixmap = _tiles[row * _columns + column];
+
+            if (!pixmap.isNull() && !kept.intersects(tileRect(column, row)))
+            {
+                pixmap = QPixmap();
+                _tilesHeld--;
+            }
+        }
+    }
 }
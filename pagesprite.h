@@ -1,21 +1,54 @@
 #ifndef PAGESPRITE_H
 #define PAGESPRITE_H
 
+#include <QImage>
 #include <QPixmap>
 
+#include <vector>
+
+using std::vector;
+
+/**
+ * @brief A decoded page, shown as a grid of fixed-size tiles.
+ *
+ * The decoded image stays on the client side; a tile is only converted to a
+ * pixmap when part of it gets painted, and is released once it scrolls out
+ * of the viewport plus a margin. The pixmap memory held for a page depends on
+ * the viewport, not on the size of the (magnified) page.
+ *
+ * The image can be smaller or bigger than the displayed size (a cached
+ * preview while the page is decoded again), in which case each tile is scaled
+ * as it's converted.
+ */
 class PageSprite
 {
 public:
     PageSprite();
     ~PageSprite();
 
-    void setPixmap(const QPixmap &pixmap);
+    void setImage(const QImage &image, const QSize &size);
     void setTopLeft(const QPoint &topLeft);
+    void setViewport(const QRect &viewport);
     void paint(QPainter *painter, const QRect &updateRect);
 
+    int tilesHeld() const;
+
+private:
+    QRect tileRect(int column, int row) const;
+    QImage tileImage(const QRect &tile) const;
+    void releaseHiddenTiles();
+
 private:
-    QPixmap _pixmap;
+    static const int TILE_SIZE;
+    static const int TILE_MARGIN;
+    QImage _image;
+    QSize _size;
     QPoint _topLeft;
+    QRect _viewport;
+    int _columns;
+    int _rows;
+    vector<QPixmap> _tiles;
+    int _tilesHeld;
 };
 
 #endif
@@ -0,0 +1,244 @@
+#include "preopener.h"
+
+#include <QSettings>
+
+#include "archive.h"
+#include "artificer.h"
+#include "book.h"
+#include "debug.h"
+#include "diskcache.h"
+#include "indexer.h"
+#include "strategist.h"
+#include "trace.h"
+
+Preopener::Preopener(DiskCache &diskCache, QObject *parent)
+    : QObject(parent),
+    _book(*new Book(this)),
+    _archive(*new Archive(this)),
+    _indexer(*new Indexer(_archive, this)),
+    _strategist(*new Strategist(_book, this)),
+    _diskCache(diskCache),
+    _artificer(*new Artificer(_archive, _indexer, _strategist, _diskCache, this))
+{
+    connect(&_book, SIGNAL(dualCausedPageChange()), SLOT(decodeSpread()));
+    connect(&_indexer, SIGNAL(built()), SLOT(indexerBuilt()));
+    connect(&_indexer, SIGNAL(grown()), SLOT(indexerGrown()));
+    connect(&_indexer, SIGNAL(extracted(qint64)), &_diskCache, SLOT(added(qint64)));
+    connect(&_strategist, SIGNAL(recievedFullPageSize(int)), SLOT(recievedFullPageSize(int)));
+    connect(&_artificer, SIGNAL(pageDecoded(int, QImage)), SLOT(decodeDone(int, QImage)));
+    connect(&_artificer, SIGNAL(pageRescaled(int, QImage)), SLOT(decodeDone(int, QImage)));
+    connect(&_artificer, SIGNAL(pageCached(int, QImage)), SLOT(decodeDone(int, QImage)));
+
+    _indexed = false;
+}
+
+Preopener::~Preopener()
+{
+    // Stop the threads first
+    delete &_artificer;
+}
+
+/**
+ * Start opening @a filename, laid out for the given view. Asking for the
+ * book that's already being opened does nothing.
+ */
+void Preopener::preopen(const QString &filename, const QSize &fullSize, const QSize &viewSize)
+{
+    if (filename == _filename)
+    {
+        return;
+    }
+
+    reset();
+
+    // Skip a book there's no program for, or that turns out to be damaged
+    if (_archive.typeOf(filename) == Archive::InvalidArchiveType
+        || !_archive.reset(filename))
+    {
+        debug()<<"Can't preopen"<<filename;
+        return;
+    }
+
+    debug()<<"Preopening"<<filename;
+    Trace::instant("preopen");
+
+    _filename = filename;
+    _strategist.setViewport(fullSize, viewSize);
+
+    // List the archive
+    _book.reset(2);
+    _strategist.reset(filename);
+    _indexer.setExtractionFolder(_diskCache.archiveFolder(_archive.identity()));
+
+    if (_archive.type() == Archive::Pack
+        || !_indexer.restore(_diskCache.listing(_archive.identity())))
+    {
+        _indexer.reset();
+    }
+}
+
+void Preopener::setViewport(const QSize &fullSize, const QSize &viewSize)
+{
+    _strategist.setViewport(fullSize, viewSize);
+
+    // Lay the first spread out again
+    if (_indexed)
+    {
+        decodeSpread();
+    }
+}
+
+/**
+ * Drop the book being opened.
+ */
+void Preopener::reset()
+{
+    _artificer.reset();
+    _filename.clear();
+    _indexed = false;
+    _pages.clear();
+}
+
+const QString &Preopener::filename() const
+{
+    return _filename;
+}
+
+/**
+ * Whether the whole book is listed (only then can the steward adopt it).
+ */
+bool Preopener::isIndexed() const
+{
+    return _indexed && _indexer.isComplete();
+}
+
+/**
+ * Whether the first spread is decoded at the size it'll be shown.
+ */
+bool Preopener::isReady() const
+{
+    if (!_indexed || _book.numPages() == 0)
+    {
+        return false;
+    }
+
+    int current[] = {_book.page0(), _book.page1()};
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (current[i] != -1
+            && _pages.value(current[i]).size() != _strategist.pageLayout(current[i]).size())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const Indexer &Preopener::indexer() const
+{
+    return _indexer;
+}
+
+const QMap<int, QImage> &Preopener::pages() const
+{
+    return _pages;
+}
+
+void Preopener::indexerBuilt()
+{
+    _indexed = true;
+
+    if (_archive.type() != Archive::Pack && _indexer.isComplete())
+    {
+        _diskCache.storeListing(_archive.identity(), _indexer.listing());
+    }
+
+    if (_indexer.numPages() == 0)
+    {
+        return;
+    }
+
+    // Lay out like the steward will
+    _book.reset(_indexer.numPages());
+    _strategist.reset(_archive.filename());
+
+    if (_archive.type() == Archive::Pack)
+    {
+        _strategist.restoreFullPageSizes(_archive.pack().fullSizes());
+    }
+    else
+    {
+        _strategist.restoreFullPageSizes(_diskCache.fullSizes(_archive.identity()));
+    }
+
+    // Start where the steward will resume the book
+    QSettings settings;
+    settings.beginGroup("positions");
+    int page = settings.value(Strategist::settingsKey(_archive.filename()), 0).toInt();
+
+    if (page > 0 && page < _book.numPages())
+    {
+        _book.setPage(page);
+    }
+
+    decodeSpread();
+}
+
+/**
+ * The rest of a book of inner archives, listed after the first spread.
+ */
+void Preopener::indexerGrown()
+{
+    _book.extend(_indexer.numPages());
+    _strategist.extend();
+
+    if (_indexer.isComplete())
+    {
+        _diskCache.storeListing(_archive.identity(), _indexer.listing());
+    }
+}
+
+void Preopener::decodeSpread()
+{
+    _artificer.decodePages(_book.page0(), _book.page1());
+}
+
+void Preopener::decodeDone(int index, QImage page)
+{
+    if (index != _book.page0() && index != _book.page1())
+    {
+        return;
+    }
+
+    QSize size = _strategist.pageLayout(index).size();
+    _pages[index] = page;
+
+    // Fix up a page decoded before its size was known
+    if (page.size() != size)
+    {
+        if (Artificer::canRescale(page.size(), size))
+        {
+            _artificer.rescalePage(index, page, size);
+        }
+        else
+        {
+            decodeSpread();
+        }
+        return;
+    }
+
+    if (isReady())
+    {
+        Trace::instant("preopened");
+        debug()<<"Preopened"<<_filename;
+        emit ready();
+    }
+}
+
+void Preopener::recievedFullPageSize(int index)
+{
+    // Remember it for when the book is opened
+    _diskCache.storeFullSize(_archive.identity(), index, _strategist.fullPageSize(index));
+}
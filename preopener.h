@@ -0,0 +1,66 @@
+#ifndef PREOPENER_H
+#define PREOPENER_H
+
+#include <QObject>
+
+#include <QImage>
+#include <QMap>
+
+class Archive;
+class Artificer;
+class Book;
+class DiskCache;
+class Indexer;
+class Strategist;
+
+/**
+ * @brief Opens the next book in the background, so moving on to it is as
+ * quick as turning a page.
+ *
+ * It lists the archive and decodes the first spread with its own engine,
+ * laid out for the same view. The steward then adopts the listing and the
+ * pages. Measured page sizes and decodes go to the disk cache as usual, so
+ * they're found again even if the pages themselves aren't adopted.
+ */
+class Preopener : public QObject
+{
+    Q_OBJECT
+
+public:
+    Preopener(DiskCache &diskCache, QObject *parent = NULL);
+    ~Preopener();
+
+    void preopen(const QString &filename, const QSize &fullSize, const QSize &viewSize);
+    void setViewport(const QSize &fullSize, const QSize &viewSize);
+    void reset();
+
+    const QString &filename() const;
+    bool isIndexed() const;
+    bool isReady() const;
+    const Indexer &indexer() const;
+    const QMap<int, QImage> &pages() const;
+
+signals:
+    void ready();
+
+private slots:
+    void indexerBuilt();
+    void indexerGrown();
+    void decodeDone(int index, QImage page);
+    void recievedFullPageSize(int index);
+    void decodeSpread();
+
+private:
+    Book &_book;
+    Archive &_archive;
+    Indexer &_indexer;
+    Strategist &_strategist;
+    DiskCache &_diskCache;
+    Artificer &_artificer;
+
+    QString _filename;
+    bool _indexed;
+    QMap<int, QImage> _pages;
+};
+
+#endif
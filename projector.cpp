@@ -2,16 +2,22 @@
 
 #include <QPalette>
 #include <QPainter>
-#include <QGuiApplication>
+
+#include <algorithm>
 
 #include "debug.h"
 #include "displaymetrics.h"
+#include "trace.h"
+
+using std::max;
 
 const double Projector::MAGNIFICATION = 2.0;
 const double Projector::FRAMES_PER_SECOND = 60.0;
+const int Projector::STATS_FRAMES = 600;
 
 Projector::Projector(QObject *parent)
-    : QObject(parent), _scroller(this), _loadingSprite(QPalette().color(QPalette::WindowText), QPalette().color(QPalette::Base))
+    : QObject(parent), _scroller(this), _loadingSprite(QPalette().color(QPalette::WindowText), QPalette().color(QPalette::Base)),
+    _paintTimes(STATS_FRAMES), _frameInterval(int(FRAMES_PER_SECOND), STATS_FRAMES)
 {
     // Show nothing
     _isShown[0] = false;
@@ -20,10 +26,16 @@ Projector::Projector(QObject *parent)
     // Connect to the scroller
     connect(&_scroller, SIGNAL(enableRefresh(bool)), SLOT(enableRefresh(bool)));
 
-    // Set the timer
-    _refreshTimer.setInterval(int(1000.0 / FRAMES_PER_SECOND + 0.5));
-    _refreshTimer.setSingleShot(true);
-    connect(&_refreshTimer, SIGNAL(timeout()), SLOT(refresh()));
+    // Frames are timed precisely, off one clock
+    _frameTimer.setTimerType(Qt::PreciseTimer);
+    _frameTimer.setSingleShot(true);
+    connect(&_frameTimer, SIGNAL(timeout()), SLOT(frame()));
+    _frameClock.start();
+    _lastFrame = 0.0;
+
+    // Nothing to draw yet
+    _isAnimating = false;
+    _isDirty = false;
 }
 
 Projector::~Projector()
@@ -42,12 +54,13 @@ void Projector::clear(const DisplayMetrics &displayMetrics)
     _isLoading[1] = true;
 
     // Set up the loading rects
-    update(displayMetrics, QPixmap(), QPixmap());
+    update(displayMetrics, QImage(), QImage());
 }
 
-void Projector::update(const DisplayMetrics &displayMetrics, const QPixmap &pixmap0, const QPixmap &pixmap1)
+void Projector::update(const DisplayMetrics &displayMetrics, const QImage &image0, const QImage &image1)
 {
-    const QPixmap *pixmap[] = {&pixmap0, &pixmap1};
+    TraceScope scope("update");
+    const QImage *image[] = {&image0, &image1};
 
     for (int i = 0; i < 2; i++)
     {
@@ -57,17 +70,18 @@ void Projector::update(const DisplayMetrics &displayMetrics, const QPixmap &pixm
             _isShown[i] = true;
             _placement[i] = displayMetrics.pages[i];
 
-            if (!pixmap[i]->isNull())
+            if (!image[i]->isNull())
             {
-                // Pixmap loaded
+                // Image loaded
                 _isLoading[i] = false;
-                _pageSprite[i].setPixmap(*pixmap[i]);
+                _pageSprite[i].setImage(*image[i], _placement[i].size());
             }
         }
     }
 
-    // Schedule a repaint
-    emit update();
+    // Show on the next frame
+    _isDirty = true;
+    requestFrame();
 }
 
 bool Projector::tryUpdate(const DisplayMetrics &displayMetrics)
@@ -111,7 +125,8 @@ bool Projector::tryUpdate(const DisplayMetrics &displayMetrics)
 
     if (failed || updateNeeded)
     {
-        emit update();
+        _isDirty = true;
+        requestFrame();
     }
 
     return !failed;
@@ -120,7 +135,11 @@ bool Projector::tryUpdate(const DisplayMetrics &displayMetrics)
 void Projector::setViewSize(const QSize &size)
 {
     _viewSize = size;
-    _fullSize = (QSizeF(_viewSize) * MAGNIFICATION).toSize();
+    _fullSize = magnifiedSize(_viewSize);
+
+    // Sprites only keep the tiles around the view
+    _pageSprite[0].setViewport(QRect(QPoint(0, 0), _viewSize));
+    _pageSprite[1].setViewport(QRect(QPoint(0, 0), _viewSize));
 }
 
 QSize Projector::viewSize() const
@@ -133,10 +152,22 @@ QSize Projector::fullSize() const
     return _fullSize;
 }
 
+/**
+ * The size pages are laid out in, for a view size.
+ */
+QSize Projector::magnifiedSize(const QSize &viewSize)
+{
+    return (QSizeF(viewSize) * MAGNIFICATION).toSize();
+}
+
 void Projector::paint(QPainter *painter, const QRect &updateRect)
 {
-    // Calculate the scrolled rects
-    QPoint scrolling = _scroller.position();
+    TraceScope scope("paint");
+    QElapsedTimer paintTime;
+    paintTime.start();
+
+    // Calculate the scrolled rects (as of the current frame)
+    QPoint scrolling = _scrollPosition;
     QRect scrolled[2];
 
     scrolled[0] = _placement[0].translated(-scrolling);
@@ -172,31 +203,113 @@ void Projector::paint(QPainter *painter, const QRect &updateRect)
         }
     }
 
-    // Refresh if scrolling or doing loading animation
-    if (_refreshRequested || (_isShown[0] && _isLoading[0]) || (_isShown[1] && _isLoading[1]))
+    // Record how long painting took
+    _paintTimes.addSample(double(paintTime.nsecsElapsed()) / 1000000.0);
+}
+
+/**
+ * Coalesce requests into one frame, at the next tick of the frame clock.
+ */
+void Projector::requestFrame()
+{
+    if (_frameTimer.isActive())
     {
-        _refreshTimer.start();
+        return;
     }
+
+    double interval = 1000.0 / FRAMES_PER_SECOND;
+    double now = double(_frameClock.nsecsElapsed()) / 1000000.0;
+    double wait = _lastFrame + interval - now;
+
+    _frameTimer.start(max(0, int(wait + 0.5)));
 }
 
-void Projector::refresh()
+void Projector::frame()
 {
-    // Pump the events, to make sure input gets handled
-    QGuiApplication::sync();
+    double interval = 1000.0 / FRAMES_PER_SECOND;
+    double now = double(_frameClock.nsecsElapsed()) / 1000000.0;
+
+    // Measure the frame rate over continuous animation
+    if (now - _lastFrame < 2.0 * interval)
+    {
+        _frameInterval.addSample(now - _lastFrame);
+    }
+    _lastFrame = now;
+
+    // Advance the animations to this frame
+    QPoint position = _scroller.position();
+    bool loading = isLoadingShown();
+    _loadingSprite.setTime(qint64(now));
+
+    // Anything could have changed, redraw it all
+    if (_isDirty)
+    {
+        _scrollPosition = position;
+        _isDirty = false;
+        emit update();
+    }
+    // Otherwise only touch what moved (or skip the frame)
+    else
+    {
+        if (position != _scrollPosition)
+        {
+            QPoint delta = _scrollPosition - position;
+            _scrollPosition = position;
+            emit scroll(delta.x(), delta.y());
+        }
 
-    // Repaint immediately
-    emit repaint();
+        if (loading)
+        {
+            emit updateRect(loadingRect());
+        }
+    }
+
+    // Keep going while there's animation
+    if (_isAnimating || loading)
+    {
+        requestFrame();
+    }
 }
 
 void Projector::enableRefresh(bool enable)
 {
-    _refreshRequested = enable;
+    _isAnimating = enable;
 
-    // If on and not running, update immediately (repeat after)
-    if (_refreshRequested && !_refreshTimer.isActive())
+    if (_isAnimating)
     {
-        emit update();
+        requestFrame();
+    }
+}
+
+bool Projector::isLoadingShown() const
+{
+    return (_isShown[0] && _isLoading[0]) || (_isShown[1] && _isLoading[1]);
+}
+
+QRect Projector::loadingRect() const
+{
+    QRect rect;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (_isShown[i] && _isLoading[i])
+        {
+            rect |= _placement[i].translated(-_scrollPosition);
+        }
     }
+
+    return rect & QRect(QPoint(0, 0), _viewSize);
+}
+
+const Distribution &Projector::paintTimes() const
+{
+    return _paintTimes;
+}
+
+double Projector::framesPerSecond() const
+{
+    double interval = _frameInterval.value();
+    return interval > 0.0 ? 1000.0 / interval : 0.0;
 }
 
 void Projector::mouseMoved(const QPointF &pos)
@@ -3,14 +3,25 @@
 
 #include <QObject>
 
+#include <QElapsedTimer>
 #include <QTimer>
 
+#include "distribution.h"
+#include "mean.h"
 #include "scroller.h"
 #include "loadingsprite.h"
 #include "pagesprite.h"
 
 struct DisplayMetrics;
 
+/**
+ * @brief Shows the current pages, or loading animations in their place.
+ *
+ * Changes are coalesced and shown on the next frame. Frames run on a fixed
+ * clock while something is animating, and are skipped when nothing changed.
+ * When only the scroll position moved, the view is asked to scroll what it
+ * has already drawn; loading animations only dirty their own area.
+ */
 class Projector : public QObject
 {
     Q_OBJECT
@@ -20,30 +31,42 @@ public:
     ~Projector();
 
     void clear(const DisplayMetrics &displayMetrics);
-    void update(const DisplayMetrics &displayMetrics, const QPixmap &pixmap0, const QPixmap &pixmap1);
+    void update(const DisplayMetrics &displayMetrics, const QImage &image0, const QImage &image1);
 
     bool tryUpdate(const DisplayMetrics &displayMetrics);
 
     void setViewSize(const QSize &size);
     QSize viewSize() const;
     QSize fullSize() const;
+    static QSize magnifiedSize(const QSize &viewSize);
 
     void paint(QPainter *painter, const QRect &updateRect);
 
     void mouseMoved(const QPointF &pos);
     void resetMouse();
 
+    bool isLoadingShown() const;
+
+    const Distribution &paintTimes() const;
+    double framesPerSecond() const;
+
 signals:
     void update();
-    void repaint();
+    void updateRect(const QRect &rect);
+    void scroll(int dx, int dy);
 
 private slots:
-    void refresh();
+    void frame();
     void enableRefresh(bool enable);
 
+private:
+    void requestFrame();
+    QRect loadingRect() const;
+
 private:
     static const double MAGNIFICATION;
     static const double FRAMES_PER_SECOND;
+    static const int STATS_FRAMES;
     QSize _viewSize;
     QSize _fullSize;
     bool _isShown[2];
@@ -51,10 +74,16 @@ private:
     QRect _placement[2];
     int _index[2];
     Scroller _scroller;
+    QPoint _scrollPosition;
     LoadingSprite _loadingSprite;
     PageSprite _pageSprite[2];
-    QTimer _refreshTimer;
-    bool _refreshRequested;
+    QTimer _frameTimer;
+    QElapsedTimer _frameClock;
+    double _lastFrame;
+    bool _isAnimating;
+    bool _isDirty;
+    Distribution _paintTimes;
+    Mean _frameInterval;
 };
 
 #endif
@@ -12,6 +12,9 @@
 using std::min;
 using std::max;
 
+const double Scroller::DRAG = 0.17;
+const double Scroller::CUTOFF = 2.0/1000.0;
+
 Scroller::Scroller(QObject *parent)
     : QObject(parent)
 {
@@ -113,41 +116,52 @@ void Scroller::timeStep()
     // Cap it out
     totalTime = min(totalTime, 1000.0);
 
-    // Evaluate each time step
-    const double TIME_STEP = 0.01;
-    const double DRAG = 0.17;
-    const double CUTOFF = 2.0/1000.0;
-    QPointF totalForce;
+    // Slide with friction
+    slide(totalTime, &_scrollPos, &_velocity);
+
+    // Stay within the extent
+    enforceBounds();
+}
 
-    double time = min(totalTime, TIME_STEP);
+/**
+ * Move for a length of time under friction alone. Solved in closed form, so
+ * the cost doesn't depend on the time passed.
+ */
+void Scroller::slide(double time, QPointF *position, QPointF *velocity)
+{
+    slideAxis(time, &position->rx(), &velocity->rx());
+    slideAxis(time, &position->ry(), &velocity->ry());
+}
 
-    while (totalTime > 0.0)
+/**
+ * With drag proportional to velocity, the velocity decays exponentially:
+ * v(t) = v0 e^(-kt), and the distance covered is v0 / k (1 - e^(-kt)). The
+ * motion stops once the speed falls under the cutoff, at
+ * t = ln(|v0| / cutoff) / k.
+ */
+void Scroller::slideAxis(double time, qreal *position, qreal *velocity)
+{
+    // Already stopped, or too slow to keep going
+    if (fabs(*velocity) < CUTOFF)
     {
-        // Add in friction
-        totalForce = - _velocity * DRAG;
-
-        // Simple acceleration
-        _velocity += totalForce * time;
-        _scrollPos += _velocity * time + 0.5 * totalForce * time * time;
-
-        // Cut off small values
-        if (fabs(_velocity.x()) < CUTOFF)
-        {
-            _velocity.setX(0.0);
-        }
-
-        if (fabs(_velocity.y()) < CUTOFF)
-        {
-            _velocity.setY(0.0);
-        }
-
-        // Go to the next time step
-        totalTime -= time;
-        time = min(totalTime, TIME_STEP);
+        *velocity = 0.0;
+        return;
     }
 
-    // Stay within the extent
-    enforceBounds();
+    // Only move until the cutoff is reached
+    double stopTime = log(fabs(*velocity) / CUTOFF) / DRAG;
+    double decay = exp(-DRAG * min(time, stopTime));
+
+    *position += *velocity / DRAG * (1.0 - decay);
+
+    if (time >= stopTime)
+    {
+        *velocity = 0.0;
+    }
+    else
+    {
+        *velocity *= decay;
+    }
 }
 
 void Scroller::enforceBounds()
@@ -25,6 +25,8 @@ public:
     void mouseMoved(const QPointF &pos);
     void resetMouse();
 
+    static void slide(double time, QPointF *position, QPointF *velocity);
+
 signals:
     void enableRefresh(bool enable);
 
@@ -32,6 +34,12 @@ private:
     void timeStep();
     void enforceBounds();
 
+    static void slideAxis(double time, qreal *position, qreal *velocity);
+
+private:
+    static const double DRAG;
+    static const double CUTOFF;
+
 private:
     bool _isReset;
     QPointF _lastMousePos;
@@ -1,14 +1,24 @@
 #include "steward.h"
 
-#include <QLabel>
+#include <QSettings>
+#include <QtConcurrentRun>
 
 #include "debug.h"
+#include "debugwidget.h"
 #include "book.h"
 #include "archive.h"
 #include "indexer.h"
 #include "strategist.h"
 #include "artificer.h"
+#include "depot.h"
+#include "diskcache.h"
 #include "projector.h"
+#include "naturalorder.h"
+#include "preopener.h"
+#include "thumbnailer.h"
+
+const int Steward::LATENCY_SAMPLES = 1000;
+const int Steward::PREOPEN_PAGES = 6;
 
 Steward::Steward(QObject *parent)
     : QObject(parent),
@@ -16,50 +26,183 @@ Steward::Steward(QObject *parent)
     _archive(*new Archive(this)),
     _indexer(*new Indexer(_archive, this)),
     _strategist(*new Strategist(_book, this)),
-    _artificer(*new Artificer(_archive, _indexer, _strategist, this)),
-    _projector(*new Projector(NULL))
+    _diskCache(*new DiskCache(this)),
+    _artificer(*new Artificer(_archive, _indexer, _strategist, _diskCache, this)),
+    _depot(*new Depot(this)),
+    _projector(*new Projector(NULL)),
+    _preopener(*new Preopener(_diskCache, this)),
+    _thumbnailer(*new Thumbnailer(_archive, _indexer, _diskCache, this)),
+    _latency(LATENCY_SAMPLES)
 {
     // Connect
     connect(&_book, SIGNAL(dualCausedPageChange()), SLOT(dualCausedPageChange()));
     connect(&_indexer, SIGNAL(built()), SLOT(indexerBuilt()));
+    connect(&_indexer, SIGNAL(grown()), SLOT(indexerGrown()));
+    connect(&_indexer, SIGNAL(extracted(qint64)), &_diskCache, SLOT(added(qint64)));
     connect(&_strategist, SIGNAL(recievedFullPageSize(int)), SLOT(recievedFullPageSize(int)));
-    connect(&_artificer, SIGNAL(pageDecoded(int, QPixmap)), SLOT(decodeDone(int, QPixmap)));
+    connect(&_artificer, SIGNAL(pageDecoded(int, QImage)), SLOT(decodeDone(int, QImage)));
+    connect(&_artificer, SIGNAL(pageRescaled(int, QImage)), SLOT(rescaleDone(int, QImage)));
+    connect(&_artificer, SIGNAL(pageCached(int, QImage)), SLOT(cacheDone(int, QImage)));
+    connect(&_thumbnailer, SIGNAL(pageSized(int, QSize)), SLOT(thumbnailSized(int, QSize)));
+    connect(&_nextFile, SIGNAL(finished()), SLOT(preopenNext()));
     connect(&_projector, SIGNAL(update()), SIGNAL(viewUpdate()));
-    connect(&_projector, SIGNAL(repaint()), SIGNAL(viewRepaint()));
+    connect(&_projector, SIGNAL(updateRect(const QRect &)), SIGNAL(viewUpdateRect(const QRect &)));
+    connect(&_projector, SIGNAL(scroll(int, int)), SIGNAL(viewScroll(int, int)));
 
     _buildingIndexer = false;
+    _warmStart = true;
+    _prefetch = true;
+    _restoredListing = false;
+    _pendingPage = -1;
+    _debugWidget = NULL;
+    _spreadSource = ColdSpread;
+    _currentDecodes = 0;
+    _wrongSizeDecodes = 0;
 }
 
 Steward::~Steward()
 {
+    savePosition();
+
+    // Not parented, as it's its own window
+    delete _debugWidget;
+
     // Stop the threads first
     delete &_artificer;
 }
 
 void Steward::reset(const QString &filename)
 {
+    // Remember where the last book was left
+    savePosition();
+
+    // Stop opening a book that isn't wanted
+    if (filename != _preopener.filename())
+    {
+        _preopener.reset();
+    }
+
+    // Find the book after this one (the folder can be large, so not here)
+    _nextFile.setFuture(QtConcurrent::run(&NaturalOrder::nextFile, filename, &_archive));
+
     // Stop decodes
     _artificer.reset();
+    _originals.clear();
+    _thumbnailer.reset();
+
+    // Forget the old pages
+    _depot.reset();
+
+    // Take over the book if it was opened ahead of time
+    bool preopened = (_warmStart && filename == _preopener.filename() && _preopener.isIndexed());
+
+    if (preopened)
+    {
+        const QMap<int, QImage> &pages = _preopener.pages();
+
+        for (QMap<int, QImage>::const_iterator i = pages.begin(); i != pages.end(); ++i)
+        {
+            _depot.store(i.key(), i.value());
+        }
+    }
 
     // Pretend two page book, show loading
     _book.reset(2);
-    _strategist.reset();
+    _strategist.reset(filename);
     _projector.clear(_strategist.pageLayout());
 
     // Retrieve the archive information
-    _archive.reset(filename);
-
-    // Start the indexerer
-    _indexer.reset();
+    bool readable = _archive.reset(filename);
 
-    // And wait
+    // Wait for the indexer (an adopted or saved listing is ready right away)
     _buildingIndexer = true;
+    _restoredListing = true;
+    _pendingPage = -1;
+    _indexer.setExtractionFolder(_diskCache.archiveFolder(_archive.identity()));
+    _diskCache.setReading(_archive.identity());
+
+    if (preopened)
+    {
+        _indexer.adopt(_preopener.indexer());
+    }
+    // (A pack lists itself straight away, and an unreadable file as empty; a
+    // folder is listed afresh, as that's how it's identified)
+    else if (_archive.type() == Archive::Pack || _archive.type() == Archive::Directory
+        || !readable)
+    {
+        _indexer.reset();
+    }
+    // (A cold start lists afresh)
+    else if (!_warmStart)
+    {
+        _restoredListing = false;
+        _indexer.reset();
+    }
+    else if (!_indexer.restore(_diskCache.listing(_archive.identity())))
+    {
+        _restoredListing = false;
+        _indexer.reset();
+    }
+
+    // The preopened book is the open one now
+    if (filename == _preopener.filename())
+    {
+        _preopener.reset();
+    }
+}
+
+void Steward::savePosition()
+{
+    if (!_warmStart || _buildingIndexer || _book.numPages() == 0)
+    {
+        return;
+    }
+
+    QSettings settings;
+    settings.beginGroup("positions");
+    settings.setValue(Strategist::settingsKey(_archive.filename()), _book.page0());
+}
+
+/**
+ * Whether to open books where they were left, from what was saved last time
+ * (the listing, page sizes, decoded pages and size guesses), and to open the
+ * next book ahead of time near the end of this one. Without it, every book
+ * opens as it did the very first time.
+ */
+void Steward::setWarmStart(bool enabled)
+{
+    _warmStart = enabled;
+    _artificer.setWarmStart(enabled);
+    _strategist.setWarmStart(enabled);
+
+    if (!_warmStart)
+    {
+        _preopener.reset();
+    }
+}
+
+/**
+ * Whether to decode the pages around the current ones ahead of time.
+ */
+void Steward::setPrefetch(bool enabled)
+{
+    _prefetch = enabled;
 }
 
 void Steward::indexerBuilt()
 {
     _buildingIndexer = false;
 
+    // A folder is identified by its images, now they're listed
+    if (_archive.type() == Archive::Directory)
+    {
+        _archive.setIdentity(_indexer.folderIdentity());
+        _diskCache.setReading(_archive.identity());
+    }
+
+    // Notify that the listing is done
+    emit indexBuilt(_indexer.numPages());
+
     // Don't do anything with an empty book
     if (_indexer.numPages() == 0)
     {
@@ -69,25 +212,257 @@ void Steward::indexerBuilt()
 
     // New book size
     _book.reset(_indexer.numPages());
-    _strategist.reset();
+    _strategist.reset(_archive.filename());
+
+    // Save the listing for next time
+    storeListing();
+
+    // Lay out with the sizes measured last time
+    restorePageSizes(0);
+
+    // Go back to where the book was left (which may not be listed yet)
+    if (_warmStart)
+    {
+        QSettings settings;
+        settings.beginGroup("positions");
+        int page = settings.value(Strategist::settingsKey(_archive.filename()), 0).toInt();
+
+        if (page > 0 && page < _book.numPages())
+        {
+            _book.setPage(page);
+        }
+        else if (page > 0 && !_indexer.isComplete())
+        {
+            _pendingPage = page;
+        }
+    }
+
+    // Or at the image that was opened, from a folder
+    if (!_archive.startPageName().isEmpty())
+    {
+        int page = _indexer.findPage(_archive.startPageName());
 
-    // Show the first two pages
+        if (page != -1)
+        {
+            _book.setPage(page);
+        }
+    }
+
+    // Show the pages, then get the ones around them ready
     pageChanged();
+    prefetchNeighbours();
+}
+
+/**
+ * More of the book has been listed (from its inner archives): the pages
+ * are added to the end, and the current ones stay. They're only reloaded if
+ * they changed, so reading isn't interrupted while the rest is listed.
+ */
+void Steward::indexerGrown()
+{
+    int first = _book.numPages();
+    int page0 = _book.page0();
+    int page1 = _book.page1();
+
+    _book.extend(_indexer.numPages());
+    _strategist.extend();
+    restorePageSizes(first);
+    storeListing();
+
+    emit indexGrown(_indexer.numPages());
+
+    // Go on to where the book was left, once it's listed
+    if (_pendingPage != -1 && (_pendingPage < _book.numPages() || _indexer.isComplete()))
+    {
+        int page = _pendingPage;
+        _pendingPage = -1;
+
+        if (page < _book.numPages())
+        {
+            _book.setPage(page);
+        }
+    }
+
+    if (_book.page0() != page0 || _book.page1() != page1)
+    {
+        pageChanged();
+    }
+    else
+    {
+        preopenNext();
+    }
+}
+
+/**
+ * Lay out pages from @a first on with the sizes measured last time (or all
+ * of them, from a pack). A cold start measures them all again.
+ */
+void Steward::restorePageSizes(int first)
+{
+    QMap<int, QSize> sizes;
+
+    if (_archive.type() == Archive::Pack)
+    {
+        sizes = _archive.pack().fullSizes();
+    }
+    else if (_warmStart)
+    {
+        sizes = _diskCache.fullSizes(_archive.identity());
+    }
+
+    // (The earlier pages are already laid out)
+    sizes.erase(sizes.begin(), sizes.lowerBound(first));
+
+    _strategist.restoreFullPageSizes(sizes);
+}
+
+/**
+ * Only a complete listing is saved, and only if it wasn't restored.
+ */
+void Steward::storeListing()
+{
+    if (!_restoredListing && _indexer.isComplete())
+    {
+        _diskCache.storeListing(_archive.identity(), _indexer.listing());
+    }
+}
+
+/**
+ * Decode the spreads on either side of the current one, after the current
+ * pages (which keep decoding).
+ */
+void Steward::prefetchNeighbours()
+{
+    if (!_prefetch)
+    {
+        return;
+    }
+
+    QList<int> pages;
+    int current[] = {_book.page0(), _book.page1()};
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (current[i] != -1 && _artificer.isDecoding(current[i]))
+        {
+            pages<<current[i];
+        }
+    }
+
+    int last = qMax(current[0], current[1]);
+    int neighbours[] = {last + 1, last + 2, current[0] - 1, current[0] - 2};
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (neighbours[i] >= 0 && neighbours[i] < _book.numPages()
+            && !_depot.contains(neighbours[i]))
+        {
+            pages<<neighbours[i];
+        }
+    }
+
+    _artificer.decodePages(pages);
+}
+
+QWidget *Steward::debugWidget()
+{
+    // Make it the first time it's needed
+    if (_debugWidget == NULL)
+    {
+        _debugWidget = new DebugWidget(*this);
+    }
+
+    return _debugWidget;
+}
+
+const LatencyMeter &Steward::latency() const
+{
+    return _latency;
+}
+
+const Artificer &Steward::artificer() const
+{
+    return _artificer;
+}
+
+const Depot &Steward::depot() const
+{
+    return _depot;
+}
+
+const DiskCache &Steward::diskCache() const
+{
+    return _diskCache;
+}
+
+const Projector &Steward::projector() const
+{
+    return _projector;
+}
+
+Thumbnailer &Steward::thumbnailer()
+{
+    return _thumbnailer;
+}
+
+Steward::SpreadSource Steward::spreadSource() const
+{
+    return _spreadSource;
+}
+
+int Steward::currentDecodes() const
+{
+    return _currentDecodes;
+}
+
+/**
+ * Decodes of the current pages that were rejected, because the page size
+ * had to be guessed when the decode started and the guess was wrong.
+ */
+int Steward::wrongSizeDecodes() const
+{
+    return _wrongSizeDecodes;
+}
+
+int Steward::page0()
+{
+    return _book.page0();
+}
+
+int Steward::page1()
+{
+    return _book.page1();
+}
+
+bool Steward::isNextEnabled()
+{
+    return _book.isNextEnabled();
 }
 
 void Steward::next()
 {
     if (_book.isNextEnabled())
     {
+        _latency.input();
         _book.next();
         pageChanged();
     }
+    // Move on to the next book at the end
+    else if (!_preopener.filename().isEmpty())
+    {
+        // (Copied, as the preopener may move on to the book after)
+        QString filename = _preopener.filename();
+
+        _latency.input();
+        reset(filename);
+    }
 }
 
 void Steward::previous()
 {
     if (_book.isPreviousEnabled())
     {
+        _latency.input();
         _book.previous();
         pageChanged();
     }
@@ -97,6 +472,7 @@ void Steward::shiftNext()
 {
     if (_book.isNextEnabled())
     {
+        _latency.input();
         _book.shiftNext();
         pageChanged();
     }
@@ -106,6 +482,7 @@ void Steward::setPage(int page)
 {
     if (page < _book.numPages())
     {
+        _latency.input();
         _book.setPage(page);
         pageChanged();
     }
@@ -118,25 +495,148 @@ void Steward::pageChanged()
 
     // Notify that the pages changed
     emit pageChanged(_book.page0(), _book.numPages());
+
+    preopenNext();
 }
 
+/**
+ * Get the next book ready when nearing the end (of the whole listing), once
+ * it's been found.
+ */
+void Steward::preopenNext()
+{
+    if (!_warmStart || !_indexer.isComplete()
+        || _book.numPages() - _book.page0() > PREOPEN_PAGES
+        || !_nextFile.isFinished() || _nextFile.future().resultCount() == 0)
+    {
+        return;
+    }
+
+    QString next = _nextFile.result();
+
+    if (!next.isEmpty())
+    {
+        _preopener.preopen(next, _projector.fullSize(), _projector.viewSize());
+    }
+}
+
+/**
+ * Pages already in the depot are shown straight away, scaled from the closest
+ * pyramid level if the layout changed. Only pages that aren't there at the
+ * right size get decoded.
+ */
 void Steward::loadPages()
 {
-    // Display loading
-    _projector.clear(_strategist.pageLayout());
+    DisplayMetrics displayMetrics = _strategist.pageLayout();
+    int current[] = {_book.page0(), _book.page1()};
+    QImage cached[2];
+    int decodes[] = {-1, -1};
+    _spreadSource = CachedSpread;
+
+    // Only the current pages' decodes are kept for resampling
+    foreach (int index, _originals.keys())
+    {
+        if (index != current[0] && index != current[1])
+        {
+            _originals.remove(index);
+        }
+    }
 
-    // Decode both pages
-    int current0 = _book.page0();
-    int current1 = _book.page1();
-    _artificer.decodePages(current0, current1);
+    // Look for cached versions of the pages
+    for (int i = 0; i < 2; i++)
+    {
+        if (current[i] != -1)
+        {
+            cached[i] = _depot.level(current[i], displayMetrics.pages[i].size());
+
+            if (cached[i].size() != displayMetrics.pages[i].size())
+            {
+                decodes[i] = current[i];
+
+                // Note the worst page's source
+                SpreadSource source;
+                if (!cached[i].isNull())
+                {
+                    source = ScaledSpread;
+                }
+                else if (_artificer.isDecoding(current[i]))
+                {
+                    source = InFlightSpread;
+                }
+                else
+                {
+                    source = ColdSpread;
+                }
+
+                _spreadSource = qMax(_spreadSource, source);
+            }
+        }
+    }
+
+    // Display loading, or the cached pages
+    _projector.clear(displayMetrics);
+    _projector.update(displayMetrics, cached[0], cached[1]);
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (current[i] != -1 && decodes[i] == -1)
+        {
+            emit pageShown(current[i]);
+        }
+    }
+
+    checkDecoded();
+
+    // Decode what's missing
+    _artificer.decodePages(decodes[0], decodes[1]);
 }
 
 /**
  * @todo Manage request queue better for failed decodes
  *   (know if each page is correct)
  */
-void Steward::decodeDone(int index, QPixmap page)
+void Steward::decodeDone(int index, QImage page)
 {
+    // Count decodes for the current pages that came out the wrong size
+    if (index == _book.page0() || index == _book.page1())
+    {
+        QRect layout = _strategist.pageLayout(index);
+        _currentDecodes++;
+
+        if (page.size() != layout.size())
+        {
+            _wrongSizeDecodes++;
+        }
+
+        // Resample from this if the layout changes
+        _originals[index] = page;
+    }
+
+    rescaleDone(index, page);
+}
+
+/**
+ * A page loaded from the disk cache or a pack: as good as a decode, but not
+ * counted as one.
+ */
+void Steward::cacheDone(int index, QImage page)
+{
+    if (index == _book.page0() || index == _book.page1())
+    {
+        _originals[index] = page;
+    }
+
+    rescaleDone(index, page);
+}
+
+/**
+ * A page resampled from another decode (which isn't counted as a decode).
+ */
+void Steward::rescaleDone(int index, QImage page)
+{
+    // Keep it for later
+    _depot.store(index, page);
+
     // Display the page if needed
     int current0 = _book.page0();
     int current1 = _book.page1();
@@ -149,13 +649,15 @@ void Steward::decodeDone(int index, QPixmap page)
         if (page.size() == displayMetrics.pages[0].size())
         {
             //qDebug()<<"Page 0"<<displayMetrics.pages[0].topLeft();
-            _projector.update(displayMetrics, page, QPixmap());
+            _projector.update(displayMetrics, page, QImage());
+            emit pageShown(index);
+            checkDecoded();
         }
-        // Or try decoding again, if needed
+        // Or fix it up, if needed
         else
         {
             debug()<<"Wrong size"<<index<<page.size();
-            _artificer.decodePages(current0, current1);
+            redecodePage(index, page, displayMetrics.pages[0].size());
         }
     }
     else if (index == current1)
@@ -166,17 +668,49 @@ void Steward::decodeDone(int index, QPixmap page)
         if (page.size() == displayMetrics.pages[1].size())
         {
             //qDebug()<<"Page 1"<<displayMetrics.pages[1].topLeft();
-            _projector.update(displayMetrics, QPixmap(), page);
+            _projector.update(displayMetrics, QImage(), page);
+            emit pageShown(index);
+            checkDecoded();
         }
-        // Or try decoding again, if needed
+        // Or fix it up, if needed
         else
         {
-            debug()<<"Wrong size"<<index;
-            _artificer.decodePages(current0, current1);
+            debug()<<"Wrong size"<<index<<page.size();
+            redecodePage(index, page, displayMetrics.pages[1].size());
         }
     }
 }
 
+/**
+ * A page decoded at the wrong size is resampled when that's good enough,
+ * and only decoded again when it would have to be enlarged a lot. Resamples
+ * are always made from the page's decode, never from another resample.
+ */
+void Steward::redecodePage(int index, const QImage &page, const QSize &size)
+{
+    QImage original = _originals.value(index, page);
+
+    if (Artificer::canRescale(original.size(), size))
+    {
+        _artificer.rescalePage(index, original, size);
+    }
+    else
+    {
+        _artificer.decodePages(_book.page0(), _book.page1());
+    }
+}
+
+/**
+ * Once nothing is loading, the navigation's pages are ready to paint.
+ */
+void Steward::checkDecoded()
+{
+    if (!_projector.isLoadingShown())
+    {
+        _latency.decoded();
+    }
+}
+
 /**
  * @todo More sophisticated do-nothing resize checks
  */
@@ -194,6 +728,12 @@ void Steward::setViewSize(const QSize &size)
     // Notify the strategist
     _strategist.setViewport(_projector.fullSize(), size);
 
+    // Lay the next book out for the new size too
+    if (!_preopener.filename().isEmpty())
+    {
+        _preopener.setViewport(_projector.fullSize(), size);
+    }
+
     // Check if the book is being opened
     if (_buildingIndexer)
     {
@@ -212,6 +752,12 @@ void Steward::paintView(QPainter *painter, const QRect &updateRect)
 {
     // Have the projector paint
     _projector.paint(painter, updateRect);
+
+    // The pages are on screen once they've been painted without loading
+    if (!_projector.isLoadingShown())
+    {
+        _latency.painted();
+    }
 }
 
 void Steward::mouseMoved(const QPointF &pos)
@@ -231,6 +777,9 @@ void Steward::resetMouse()
  */
 void Steward::recievedFullPageSize(int index)
 {
+    // Remember it for next time
+    _diskCache.storeFullSize(_archive.identity(), index, _strategist.fullPageSize(index));
+
     // Update the projector's display if a current page was affected
     int current0 = _book.page0();
     int current1 = _book.page1();
@@ -252,3 +801,15 @@ void Steward::dualCausedPageChange()
     // Reload the current pages
     loadPages();
 }
+
+/**
+ * Thumbnails read the page size from the header, which saves measuring the
+ * page when it's decoded.
+ */
+void Steward::thumbnailSized(int index, QSize size)
+{
+    if (!_buildingIndexer && !_strategist.isFullPageSizeKnown(index))
+    {
+        _strategist.setFullPageSize(index, size);
+    }
+}
@@ -3,14 +3,22 @@
 
 #include <QObject>
 
-#include <QPixmap>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMap>
+
+#include "latencymeter.h"
 
 class Book;
 class Archive;
 class Indexer;
 class Strategist;
 class Artificer;
+class Depot;
+class DiskCache;
 class Projector;
+class Preopener;
+class Thumbnailer;
 
 /**
  * @todo Use QAction for actions
@@ -19,13 +27,40 @@ class Steward : public QObject
 {
     Q_OBJECT
 
+public:
+    /**
+     * Where the current pages came from, best first.
+     */
+    enum SpreadSource
+    {
+        CachedSpread = 0,
+        ScaledSpread,
+        InFlightSpread,
+        ColdSpread
+    };
+
 public:
     Steward(QObject *parent = NULL);
     ~Steward();
 
     QWidget *debugWidget();
+    const LatencyMeter &latency() const;
+    const Artificer &artificer() const;
+    const Depot &depot() const;
+    const DiskCache &diskCache() const;
+    const Projector &projector() const;
+    Thumbnailer &thumbnailer();
+    SpreadSource spreadSource() const;
+    int currentDecodes() const;
+    int wrongSizeDecodes() const;
 
     void reset(const QString &filename);
+    void setWarmStart(bool enabled);
+    void setPrefetch(bool enabled);
+
+    int page0();
+    int page1();
+    bool isNextEnabled();
 
     void setViewSize(const QSize &size);
     void paintView(QPainter *painter, const QRect &updateRect);
@@ -41,28 +76,63 @@ public slots:
 
 signals:
     void viewUpdate();
-    void viewRepaint();
+    void viewUpdateRect(const QRect &rect);
+    void viewScroll(int dx, int dy);
     void pageChanged(int page, int total);
+    void indexBuilt(int numPages);
+    void indexGrown(int numPages);
+    void pageShown(int index);
 
 private slots:
     void indexerBuilt();
-    void decodeDone(int index, QPixmap page);
+    void indexerGrown();
+    void decodeDone(int index, QImage page);
+    void rescaleDone(int index, QImage page);
+    void cacheDone(int index, QImage page);
     void recievedFullPageSize(int index);
     void dualCausedPageChange();
+    void thumbnailSized(int index, QSize size);
+    void preopenNext();
 
 private:
     void pageChanged();
     void loadPages();
+    void checkDecoded();
+    void prefetchNeighbours();
+    void savePosition();
+    void restorePageSizes(int first);
+    void storeListing();
+    void redecodePage(int index, const QImage &page, const QSize &size);
 
 private:
     Book &_book;
     Archive &_archive;
     Indexer &_indexer;
     Strategist &_strategist;
+    DiskCache &_diskCache;
     Artificer &_artificer;
+    Depot &_depot;
     Projector &_projector;
+    Preopener &_preopener;
+    Thumbnailer &_thumbnailer;
+
+    static const int LATENCY_SAMPLES;
+    static const int PREOPEN_PAGES;
 
     bool _buildingIndexer;
+    bool _warmStart;
+    bool _prefetch;
+    bool _restoredListing;
+    int _pendingPage;
+
+    QFutureWatcher<QString> _nextFile;
+    QMap<int, QImage> _originals;
+
+    LatencyMeter _latency;
+    SpreadSource _spreadSource;
+    int _currentDecodes;
+    int _wrongSizeDecodes;
+    QWidget *_debugWidget;
 };
 
 #endif
@@ -1,6 +1,8 @@
 #include "strategist.h"
 
+#include <QCryptographicHash>
 #include <QMutex>
+#include <QSettings>
 
 #include <algorithm>
 
@@ -17,17 +19,53 @@ Strategist::Strategist(Book &book, QObject *parent)
     : QObject(parent), _book(book)
 {
     _numPages = 0;
+    _warmStart = true;
 }
 
 Strategist::~Strategist()
 {
 }
 
-void Strategist::reset()
+/**
+ * Unmeasured pages are guessed to be the most common size measured so far.
+ * Before any are measured, the guess comes from the last time this book was
+ * read, or else from the last book read (only when a key is given, so
+ * unnamed books always start from the default).
+ */
+void Strategist::reset(const QString &bookKey)
 {
     _numPages = _book.numPages();
     _fullSizes.clear();
     _fullSizes.resize(_numPages);
+
+    // Start the guess from the prior
+    _bookKey = bookKey;
+    _predictedSize = QSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    _sizeCounts.clear();
+    _predictedCount = 0;
+
+    if (_warmStart && !_bookKey.isEmpty())
+    {
+        QSettings settings;
+        settings.beginGroup("pageSizes");
+
+        QSize prior = settings.value(settingsKey(_bookKey),
+            settings.value("global")).toSize();
+
+        if (prior.isValid())
+        {
+            _predictedSize = prior;
+        }
+    }
+}
+
+/**
+ * Whether to guess from the sizes learned earlier, and to learn them. A cold
+ * start does neither, so it lays out like the very first opening.
+ */
+void Strategist::setWarmStart(bool enabled)
+{
+    _warmStart = enabled;
 }
 
 DisplayMetrics Strategist::pageLayout()
@@ -94,8 +132,8 @@ DisplayMetrics Strategist::pageLayout(int page0, int page1)
 
         if (!fullSize0.isValid() && !fullSize1.isValid())
         {
-            fullSize0 = QSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
-            fullSize1 = QSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+            fullSize0 = _predictedSize;
+            fullSize1 = _predictedSize;
         }
         else if (!fullSize0.isValid())
         {
@@ -122,7 +160,7 @@ DisplayMetrics Strategist::pageLayout(int page0, int page1)
 
         if (!fullSize0.isValid())
         {
-            fullSize0 = QSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+            fullSize0 = _predictedSize;
         }
 
         // Calculate layout for the page
@@ -257,6 +295,24 @@ bool Strategist::isFullPageSizeKnown(int index)
     return _fullSizes[index].isValid();
 }
 
+QSize Strategist::fullPageSize(int index)
+{
+    Q_ASSERT(index >= 0 && index < _numPages);
+
+    return _fullSizes[index];
+}
+
+/**
+ * Follow the book as pages are added, keeping the sizes already known.
+ */
+void Strategist::extend()
+{
+    Q_ASSERT(_book.numPages() >= _numPages);
+
+    _numPages = _book.numPages();
+    _fullSizes.resize(_numPages);
+}
+
 /**
  * @todo Handle double-message for current and dual
  */
@@ -271,13 +327,84 @@ void Strategist::setFullPageSize(int index, QSize size)
     {
         _book.setDual(index);
     }
+    // Or improve the guess for single pages
+    else
+    {
+        learnPageSize(size);
+    }
 
     // Layouts and caches may need to change
     emit recievedFullPageSize(index);
 }
 
+/**
+ * Sizes remembered from an earlier reading, set before the book is shown (so
+ * without notification).
+ */
+void Strategist::restoreFullPageSizes(const QMap<int, QSize> &sizes)
+{
+    for (QMap<int, QSize>::const_iterator i = sizes.begin(); i != sizes.end(); ++i)
+    {
+        if (i.key() < 0 || i.key() >= _numPages || !i.value().isValid())
+        {
+            continue;
+        }
+
+        _fullSizes[i.key()] = i.value();
+
+        if (double(i.value().width()) / double(i.value().height()) >= DUAL_PAGE_RATIO)
+        {
+            _book.setDual(i.key());
+        }
+        else
+        {
+            learnPageSize(i.value());
+        }
+    }
+}
+
 void Strategist::setViewport(const QSize &fullSize, const QSize &viewSize)
 {
     _viewport = fullSize;
     _visibleSize = viewSize;
 }
+
+QSize Strategist::predictedPageSize() const
+{
+    return _predictedSize;
+}
+
+void Strategist::learnPageSize(QSize size)
+{
+    // Count it, and see if it's now the most common
+    int &count = _sizeCounts[qMakePair(size.width(), size.height())];
+    count++;
+
+    if (count <= _predictedCount)
+    {
+        return;
+    }
+
+    bool changed = (size != _predictedSize || _predictedCount == 0);
+    _predictedSize = size;
+    _predictedCount = count;
+
+    // Remember it for next time
+    if (changed && _warmStart && !_bookKey.isEmpty())
+    {
+        QSettings settings;
+        settings.beginGroup("pageSizes");
+        settings.setValue(settingsKey(_bookKey), _predictedSize);
+        settings.setValue("global", _predictedSize);
+    }
+}
+
+/**
+ * A short key for a book in the settings. Book keys are file paths, so
+ * they're hashed to keep the settings file tidy.
+ */
+QString Strategist::settingsKey(const QString &bookKey)
+{
+    return QString::fromLatin1(
+        QCryptographicHash::hash(bookKey.toUtf8(), QCryptographicHash::Md5).toHex());
+}
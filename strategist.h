@@ -3,7 +3,10 @@
 
 #include <QObject>
 
+#include <QMap>
+#include <QPair>
 #include <QRect>
+#include <QString>
 
 #include <vector>
 
@@ -23,16 +26,24 @@ public:
     Strategist(Book &book, QObject *parent = NULL);
     ~Strategist();
 
-    void reset();
+    void reset(const QString &bookKey = QString());
+    void extend();
+    void setWarmStart(bool enabled);
 
     DisplayMetrics pageLayout();
     QRect pageLayout(int index);
 
     bool isFullPageSizeKnown(int index);
+    QSize fullPageSize(int index);
     void setFullPageSize(int index, QSize size);
+    void restoreFullPageSizes(const QMap<int, QSize> &sizes);
 
     void setViewport(const QSize &fullSize, const QSize &viewSize);
 
+    QSize predictedPageSize() const;
+
+    static QString settingsKey(const QString &bookKey);
+
 signals:
     void recievedFullPageSize(int index);
 
@@ -46,6 +57,7 @@ private:
     DisplayMetrics layOutPages(QSize fullSize0, QSize fullSize1);
     void convertToLargestHeight(QSize *size0, QSize *size1);
     DisplayMetrics layOutPage(QSize fullSize);
+    void learnPageSize(QSize size);
 
 private:
     Book &_book;
@@ -53,6 +65,12 @@ private:
     QSize _visibleSize;
     int _numPages;
     vector<QSize> _fullSizes;
+
+    QString _bookKey;
+    bool _warmStart;
+    QSize _predictedSize;
+    QMap<QPair<int, int>, int> _sizeCounts;
+    int _predictedCount;
 };
 
 #endif
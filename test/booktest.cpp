@@ -775,3 +775,64 @@ void BookTest::persistentShiftedParity()
     PAIRED(8, -1);
     PAIRED(9, 10);
 }
+
+/**
+ * Test that pages added to the end keep the current pages and dual pages,
+ * and pair a solitary last page.
+ */
+void BookTest::extending()
+{
+    _book.reset(5);
+    _book.setDual(1);
+
+    // Go to the solitary last page
+    _book.setPage(4);
+    CURRENT(4, -1);
+
+    // It's paired with the new page
+    _book.extend(7);
+    CURRENT(4, 5);
+    QVERIFY(_book.isDual(1));
+    PAIRED(2, 3);
+    PAIRED(6, -1);
+
+    // Turning carries on into the new pages
+    QVERIFY(_book.isNextEnabled());
+    _book.next();
+    CURRENT(6, -1);
+    QVERIFY(!_book.isNextEnabled());
+
+    // A dual last page stays on its own
+    _book.reset(3);
+    _book.setDual(2);
+    _book.setPage(2);
+    _book.extend(5);
+    CURRENT(2, -1);
+    PAIRED(3, 4);
+}
+
+/**
+ * Bulk probing of a very long book: learn dual pages from front to back (the
+ * worst case for re-pairing the following pages) while looking up pairs.
+ */
+void BookTest::scaling()
+{
+    const int PAGES = 100000;
+    const int DUAL_SPACING = 7;
+
+    QBENCHMARK
+    {
+        _book.reset(PAGES);
+
+        for (int page = DUAL_SPACING; page < PAGES - 1; page += DUAL_SPACING)
+        {
+            _book.setDual(page);
+            _book.pairedPage(page + 1);
+            _book.pairedPage(page - 1);
+        }
+    }
+
+    // Pairing still starts after each dual page
+    PAIRED(DUAL_SPACING + 1, DUAL_SPACING + 2);
+    PAIRED(99996, 99997);
+}
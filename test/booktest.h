@@ -31,6 +31,8 @@ private slots:
     void shiftingCoverage();
     void currentDualWithShifting();
     void persistentShiftedParity();
+    void extending();
+    void scaling();
 
 private:
     Book _book;
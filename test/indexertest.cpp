@@ -0,0 +1,254 @@
+#include "indexertest.h"
+
+#include <QTest>
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include "archive.h"
+#include "debug.h"
+#include "imagesource.h"
+#include "indexer.h"
+#include "testarchive.h"
+
+static const qint64 FIVE_GB = Q_INT64_C(5) * 1024 * 1024 * 1024;
+static const qint64 THREE_GB = Q_INT64_C(3) * 1024 * 1024 * 1024;
+
+IndexerTest::IndexerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+IndexerTest::~IndexerTest()
+{
+}
+
+/**
+ * Test that a tar archive totalling over 4 GB lists with the full sizes.
+ * The pages are sparse files, so the archive itself stays small.
+ */
+void IndexerTest::largeEntries()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Make the sparse pages
+    QFile page0(dir.path() + "/001.tiff");
+    QVERIFY(page0.open(QIODevice::WriteOnly));
+    QVERIFY(page0.resize(FIVE_GB));
+    page0.close();
+
+    QFile page1(dir.path() + "/002.tiff");
+    QVERIFY(page1.open(QIODevice::WriteOnly));
+    QVERIFY(page1.resize(THREE_GB));
+    page1.close();
+
+    // Archive them, keeping the holes
+    if (!TestArchive::hasTar())
+    {
+        QSKIP("tar is not available");
+    }
+    QVERIFY(TestArchive::tar(dir.path(), QStringList()<<"-cSf"<<"book.tar"<<"001.tiff"<<"002.tiff"));
+
+    // List the archive
+    Archive archive;
+    archive.reset(dir.path() + "/book.tar");
+
+    Indexer indexer(archive);
+    QSignalSpy built(&indexer, SIGNAL(built()));
+    indexer.reset();
+    QVERIFY(built.wait(10000));
+
+    // Sizes should come through untruncated
+    QCOMPARE(indexer.numPages(), 2);
+    QCOMPARE(indexer.uncompressedSize(0), FIVE_GB);
+    QCOMPARE(indexer.uncompressedSize(1), THREE_GB);
+
+    // A saved listing comes back the same
+    Indexer restored(archive);
+    QVERIFY(restored.restore(indexer.listing()));
+    QCOMPARE(restored.numPages(), 2);
+    QCOMPARE(restored.pageName(1), indexer.pageName(1));
+    QCOMPARE(restored.uncompressedSize(0), FIVE_GB);
+
+    // And a damaged one is refused
+    QVERIFY(!restored.restore(indexer.listing().left(12)));
+    QCOMPARE(restored.numPages(), 2);
+}
+
+/**
+ * Test that an image source reports and seeks within a size past 4 GB.
+ */
+void IndexerTest::largeSource()
+{
+    QByteArray data("0123456789");
+    QBuffer proxy(&data);
+    QVERIFY(proxy.open(QIODevice::ReadOnly));
+
+    ImageSource source(&proxy, FIVE_GB);
+    QCOMPARE(source.size(), FIVE_GB);
+
+    // Read from the start
+    QCOMPARE(source.read(4), QByteArray("0123"));
+
+    // Read after seeking
+    QVERIFY(source.seek(6));
+    QCOMPARE(source.read(4), QByteArray("6789"));
+
+    // Seeking is allowed anywhere inside the full size
+    QVERIFY(source.seek(FIVE_GB - 1));
+    QCOMPARE(source.pos(), FIVE_GB - 1);
+    QVERIFY(!source.seek(FIVE_GB + 1));
+    QCOMPARE(source.pos(), FIVE_GB - 1);
+}
+
+/**
+ * Test that a folder lists only its images, in natural order, and that
+ * opening one image opens the folder at it.
+ */
+void IndexerTest::directory()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QImage page(6, 9, QImage::Format_RGB32);
+    page.fill(Qt::white);
+
+    QStringList names;
+    names<<"page 10.png"<<"page 2.png"<<"page 1.png";
+
+    foreach (const QString &name, names)
+    {
+        QVERIFY(page.save(dir.path() + "/" + name));
+    }
+
+    QFile notes(dir.path() + "/notes.txt");
+    QVERIFY(notes.open(QIODevice::WriteOnly));
+    notes.write("not a page");
+    notes.close();
+
+    // Open one of the images
+    Archive archive;
+    archive.reset(dir.path() + "/page 2.png");
+    QCOMPARE(archive.type(), Archive::Directory);
+    QCOMPARE(archive.filename(), dir.path());
+    QCOMPARE(archive.startPageName(), QByteArray("page 2.png"));
+
+    Indexer indexer(archive);
+    QSignalSpy built(&indexer, SIGNAL(built()));
+    indexer.reset();
+    QVERIFY(built.wait(10000));
+
+    QCOMPARE(indexer.numPages(), 3);
+    QCOMPARE(indexer.pageName(0), QByteArray("page 1.png"));
+    QCOMPARE(indexer.pageName(1), QByteArray("page 2.png"));
+    QCOMPARE(indexer.pageName(2), QByteArray("page 10.png"));
+    QCOMPARE(indexer.findPage(archive.startPageName()), 1);
+    QCOMPARE(indexer.uncompressedSize(2), QFileInfo(dir.path() + "/page 10.png").size());
+
+    // Pages are read without an extracter
+    QByteArray data = Archive::extract(archive.type(), archive.filename(),
+        archive.programPath(), indexer.pageName(0), 1000);
+    QVERIFY(QImage::fromData(data, "PNG").size() == QSize(6, 9));
+
+    // The folder itself opens at the start
+    archive.reset(dir.path());
+    QCOMPARE(archive.type(), Archive::Directory);
+    QVERIFY(archive.startPageName().isEmpty());
+
+    Indexer folder(archive);
+    folder.build();
+    QCOMPARE(folder.numPages(), 3);
+
+    // Replacing an image in place makes it a different book
+    QVERIFY(!folder.folderIdentity().isEmpty());
+    QVERIFY(QImage(7, 9, QImage::Format_RGB32).save(dir.path() + "/page 1.png"));
+
+    Indexer changed(archive);
+    changed.build();
+    QVERIFY(changed.folderIdentity() != folder.folderIdentity());
+
+    // A file that isn't a book can't be read, and lists as empty
+    QVERIFY(!archive.reset(dir.path() + "/notes.txt"));
+    QCOMPARE(archive.type(), Archive::InvalidArchiveType);
+
+    Indexer unreadable(archive);
+    unreadable.build();
+    QCOMPARE(unreadable.numPages(), 0);
+}
+
+/**
+ * Test that the archives inside a book are extracted and listed in place,
+ * so their pages follow on from the book's own, and that the listing comes
+ * back while they stay extracted.
+ */
+void IndexerTest::nested()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QImage page(6, 9, QImage::Format_RGB32);
+    page.fill(Qt::white);
+    QVERIFY(page.save(dir.path() + "/000.png"));
+    QVERIFY(page.save(dir.path() + "/a.png"));
+    QVERIFY(page.save(dir.path() + "/b.png"));
+    QVERIFY(page.save(dir.path() + "/c.png"));
+
+    // Two chapters (numbered past 9), then the book around them
+    QStringList commands;
+    commands<<"-cf ch2.tar a.png b.png"<<"-cf ch10.tar c.png"
+        <<"-cf book.tar ch10.tar 000.png ch2.tar";
+
+    if (!TestArchive::hasTar())
+    {
+        QSKIP("tar is not available");
+    }
+
+    foreach (const QString &command, commands)
+    {
+        QVERIFY(TestArchive::tar(dir.path(), command.split(' ')));
+    }
+
+    Archive archive;
+    archive.reset(dir.path() + "/book.tar");
+
+    Indexer indexer(archive);
+    indexer.setExtractionFolder(dir.path() + "/archives");
+    QSignalSpy built(&indexer, SIGNAL(built()));
+    indexer.build();
+
+    // The chapters take their places in the book, in natural order
+    QVERIFY(indexer.isComplete());
+    QCOMPARE(built.count(), 1);
+    QCOMPARE(indexer.numPages(), 4);
+    QCOMPARE(indexer.pageName(0), QByteArray("000.png"));
+    QCOMPARE(indexer.pageName(1), QByteArray("a.png"));
+    QCOMPARE(indexer.pageName(2), QByteArray("b.png"));
+    QCOMPARE(indexer.pageName(3), QByteArray("c.png"));
+
+    // And their pages are read from them
+    QCOMPARE(&indexer.pageArchive(0), &archive);
+    QVERIFY(indexer.pageArchive(1).filename() != indexer.pageArchive(3).filename());
+
+    const Archive &chapter = indexer.pageArchive(2);
+    QCOMPARE(chapter.type(), Archive::Tar);
+    QByteArray data = Archive::extract(chapter.type(), chapter.filename(),
+        chapter.programPath(), indexer.pageName(2), 10000);
+    QVERIFY(QImage::fromData(data, "PNG").size() == QSize(6, 9));
+
+    // The listing comes back, with the chapters already extracted
+    Indexer restored(archive);
+    restored.setExtractionFolder(dir.path() + "/archives");
+    QVERIFY(restored.restore(indexer.listing()));
+    QCOMPARE(restored.numPages(), 4);
+    QCOMPARE(restored.pageArchive(3).filename(), indexer.pageArchive(3).filename());
+
+    // But not once they're gone
+    QVERIFY(QFile::remove(chapter.filename()));
+    Indexer stale(archive);
+    stale.setExtractionFolder(dir.path() + "/archives");
+    QVERIFY(!stale.restore(indexer.listing()));
+}
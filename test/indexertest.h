@@ -0,0 +1,26 @@
+#ifndef INDEXERTEST_H
+#define INDEXERTEST_H
+
+#include <QObject>
+
+/**
+ * @brief Unit testing for Indexer and ImageSource. Checks that entry sizes
+ * past the 32-bit range survive listing and buffering, that folders list
+ * in natural order, and that archives inside archives list as one book.
+ */
+class IndexerTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    IndexerTest(QObject *parent = 0);
+    ~IndexerTest();
+
+private slots:
+    void largeEntries();
+    void largeSource();
+    void directory();
+    void nested();
+};
+
+#endif
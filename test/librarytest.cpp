@@ -0,0 +1,114 @@
+#include "librarytest.h"
+
+#include <QTest>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include "library.h"
+#include "testarchive.h"
+
+LibraryTest::LibraryTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+LibraryTest::~LibraryTest()
+{
+}
+
+/**
+ * Some small pages, all the same size.
+ */
+bool LibraryTest::makeArchive(const QString &path, int numPages)
+{
+    QList<QSize> sizes;
+
+    for (int i = 0; i < numPages; i++)
+    {
+        sizes<<QSize(60, 90);
+    }
+
+    return TestArchive::makeBook(path, sizes);
+}
+
+bool LibraryTest::scan(Library &library, const QStringList &roots)
+{
+    QSignalSpy scanned(&library, SIGNAL(scanned()));
+    library.scan(roots);
+    return scanned.wait(30000);
+}
+
+void LibraryTest::rescan()
+{
+    QTemporaryDir books;
+    QTemporaryDir location;
+    QVERIFY(books.isValid());
+    QVERIFY(location.isValid());
+
+    if (!TestArchive::hasTar())
+    {
+        QSKIP("tar is not available");
+    }
+    QVERIFY(makeArchive(books.path() + "/a.tar", 1));
+    QVERIFY(makeArchive(books.path() + "/series/b.tar", 2));
+
+    QStringList roots;
+    roots<<books.path();
+
+    {
+        // First scan lists everything
+        Library library(location.path());
+        QVERIFY(scan(library, roots));
+        QCOMPARE(library.numExamined(), 2);
+
+        QList<Library::Entry> entries = library.entries();
+        QCOMPARE(entries.size(), 2);
+        QCOMPARE(entries[0].numPages, 1);
+        QCOMPARE(entries[1].numPages, 2);
+        QCOMPARE(entries[1].pageSize, QSize(60, 90));
+
+        // Nothing changed
+        QVERIFY(scan(library, roots));
+        QCOMPARE(library.numExamined(), 0);
+    }
+
+    // The index is read back, so nothing needs listing
+    Library library(location.path());
+    QCOMPARE(library.entries().size(), 2);
+    QVERIFY(scan(library, roots));
+    QCOMPARE(library.numExamined(), 0);
+
+    // Only the changed archive is listed again
+    QVERIFY(makeArchive(books.path() + "/series/b.tar", 3));
+    QVERIFY(scan(library, roots));
+    QCOMPARE(library.numExamined(), 1);
+    QCOMPARE(library.entries()[1].numPages, 3);
+
+    // Removed archives are dropped
+    QVERIFY(QFile::remove(books.path() + "/a.tar"));
+    QVERIFY(scan(library, roots));
+    QCOMPARE(library.entries().size(), 1);
+}
+
+void LibraryTest::unreadable()
+{
+    QTemporaryDir books;
+    QTemporaryDir location;
+    QVERIFY(books.isValid());
+    QVERIFY(location.isValid());
+
+    // A pack that isn't one
+    QFile pack(books.path() + "/damaged.ykp");
+    QVERIFY(pack.open(QIODevice::WriteOnly));
+    pack.write("not a pack");
+    pack.close();
+
+    Library library(location.path());
+    QVERIFY(scan(library, QStringList()<<books.path()));
+
+    QList<Library::Entry> entries = library.entries();
+    QCOMPARE(entries.size(), 1);
+    QCOMPARE(entries[0].numPages, 0);
+    QVERIFY(entries[0].cover.isEmpty());
+}
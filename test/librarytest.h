@@ -0,0 +1,32 @@
+#ifndef LIBRARYTEST_H
+#define LIBRARYTEST_H
+
+#include <QObject>
+
+#include <QStringList>
+
+class Library;
+
+/**
+ * @brief Unit testing for Library. Checks that rescans only list new and
+ * changed archives, that the index survives a restart, and that damaged
+ * archives are kept without pages.
+ */
+class LibraryTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    LibraryTest(QObject *parent = 0);
+    ~LibraryTest();
+
+private slots:
+    void rescan();
+    void unreadable();
+
+private:
+    static bool makeArchive(const QString &path, int numPages);
+    static bool scan(Library &library, const QStringList &roots);
+};
+
+#endif
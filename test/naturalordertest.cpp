@@ -0,0 +1,68 @@
+#include "naturalordertest.h"
+
+#include <QTest>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "archive.h"
+#include "naturalorder.h"
+
+NaturalOrderTest::NaturalOrderTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+NaturalOrderTest::~NaturalOrderTest()
+{
+}
+
+void NaturalOrderTest::sort()
+{
+    QStringList names;
+    names<<"Vol 10.cbz"<<"vol 2.cbz"<<"Vol 1.cbz"<<"vol 02 extra.cbz"<<"Vol 9.cbz"<<"Extras.cbz";
+    NaturalOrder::sort(names);
+
+    QStringList expected;
+    expected<<"Extras.cbz"<<"Vol 1.cbz"<<"vol 02 extra.cbz"<<"vol 2.cbz"<<"Vol 9.cbz"<<"Vol 10.cbz";
+    QCOMPARE(names, expected);
+
+    // Leading zeros don't change the value, but still give a total order
+    QVERIFY(NaturalOrder::lessThan("p007", "p8"));
+    QVERIFY(NaturalOrder::lessThan("p07", "p7") != NaturalOrder::lessThan("p7", "p07"));
+}
+
+void NaturalOrderTest::nextFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // (Packs are always readable, as they need no program)
+    Archive archive;
+
+    QStringList names;
+    names<<"book 1.ykp"<<"book 2.ykp"<<"book 10.ykp"<<"notes.txt";
+
+    foreach (const QString &name, names)
+    {
+        QFile file(dir.path() + "/" + name);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+
+    QCOMPARE(NaturalOrder::nextFile(dir.path() + "/book 1.ykp", &archive), dir.path() + "/book 2.ykp");
+    QCOMPARE(NaturalOrder::nextFile(dir.path() + "/book 2.ykp", &archive), dir.path() + "/book 10.ykp");
+
+    // The last archive has no next one, even with other files after it
+    QVERIFY(NaturalOrder::nextFile(dir.path() + "/book 10.ykp", &archive).isEmpty());
+
+    // Archives without a program to read them are passed over
+    if (archive.typeOf("book 3.rar") != Archive::InvalidArchiveType)
+    {
+        QSKIP("rar archives are readable");
+    }
+
+    QFile rar(dir.path() + "/book 3.rar");
+    QVERIFY(rar.open(QIODevice::WriteOnly));
+    rar.close();
+
+    QCOMPARE(NaturalOrder::nextFile(dir.path() + "/book 2.ykp", &archive), dir.path() + "/book 10.ykp");
+}
@@ -0,0 +1,22 @@
+#ifndef NATURALORDERTEST_H
+#define NATURALORDERTEST_H
+
+#include <QObject>
+
+/**
+ * @brief Unit testing for NaturalOrder.
+ */
+class NaturalOrderTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    NaturalOrderTest(QObject *parent = 0);
+    ~NaturalOrderTest();
+
+private slots:
+    void sort();
+    void nextFile();
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "packedimagetest.h"
+
+#include <QTest>
+
+#include "packedimage.h"
+
+/** Size of the test page */
+static const int PAGE_WIDTH = 1200;
+static const int PAGE_HEIGHT = 1800;
+
+PackedImageTest::PackedImageTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PackedImageTest::~PackedImageTest()
+{
+}
+
+/**
+ * A page like a scanned comic: white, with panel borders, flat fills and a
+ * screentone.
+ */
+QImage PackedImageTest::drawnPage(QImage::Format format)
+{
+    QImage page(PAGE_WIDTH, PAGE_HEIGHT, QImage::Format_RGB32);
+    page.fill(Qt::white);
+
+    for (int y = 0; y < PAGE_HEIGHT; y++)
+    {
+        QRgb *row = reinterpret_cast<QRgb *>(page.scanLine(y));
+
+        for (int x = 0; x < PAGE_WIDTH; x++)
+        {
+            // Borders
+            if (x % 400 < 4 || y % 600 < 4)
+            {
+                row[x] = qRgb(0, 0, 0);
+            }
+            // A screentone in one panel
+            else if (x < 400 && y < 600 && (x + y) % 4 == 0)
+            {
+                row[x] = qRgb(40, 40, 40);
+            }
+            // A grey fill in another
+            else if (x >= 800 && y >= 1200)
+            {
+                row[x] = qRgb(128, 128, 128);
+            }
+        }
+    }
+
+    return page.convertToFormat(format);
+}
+
+QImage PackedImageTest::noise(QImage::Format format, int width, int height)
+{
+    QImage image(width, height, format);
+    quint32 state = 12345;
+
+    for (int y = 0; y < height; y++)
+    {
+        uchar *row = image.scanLine(y);
+
+        for (int i = 0; i < image.bytesPerLine(); i++)
+        {
+            // Mostly random, with some short runs
+            state = state * 1103515245 + 12345;
+            row[i] = (state >> 28) < 3 ? 0 : uchar(state >> 16);
+        }
+    }
+
+    return image;
+}
+
+void PackedImageTest::roundTrip_data()
+{
+    QTest::addColumn<QImage>("image");
+
+    QTest::newRow("drawn rgb32")<<drawnPage(QImage::Format_RGB32);
+    QTest::newRow("drawn argb32")<<drawnPage(QImage::Format_ARGB32_Premultiplied);
+    QTest::newRow("drawn grey")<<drawnPage(QImage::Format_Grayscale8);
+    QTest::newRow("noise rgb32")<<noise(QImage::Format_RGB32, 333, 77);
+    QTest::newRow("noise grey")<<noise(QImage::Format_Grayscale8, 333, 77);
+    QTest::newRow("wide grey")<<noise(QImage::Format_Grayscale8, 40000, 3);
+    QTest::newRow("one pixel")<<noise(QImage::Format_RGB32, 1, 1);
+}
+
+void PackedImageTest::roundTrip()
+{
+    QFETCH(QImage, image);
+
+    PackedImage packed = PackedImage::pack(image);
+    QCOMPARE(packed.unpackedBytes(), qint64(image.byteCount()));
+    QCOMPARE(packed.unpack(), image);
+}
+
+/**
+ * Formats that aren't packed are kept as they are.
+ */
+void PackedImageTest::unpackedFormats()
+{
+    QImage image = drawnPage(QImage::Format_RGB32).convertToFormat(QImage::Format_Indexed8);
+
+    PackedImage packed = PackedImage::pack(image);
+    QCOMPARE(packed.packedBytes(), qint64(image.byteCount()));
+    QCOMPARE(packed.unpack(), image);
+}
+
+void PackedImageTest::ratio()
+{
+    PackedImage packed = PackedImage::pack(drawnPage(QImage::Format_RGB32));
+    double ratio = double(packed.unpackedBytes()) / double(packed.packedBytes());
+
+    QVERIFY(ratio > 20.0);
+}
+
+void PackedImageTest::unpack()
+{
+    PackedImage packed = PackedImage::pack(drawnPage(QImage::Format_RGB32));
+    QImage image;
+
+    QBENCHMARK
+    {
+        image = packed.unpack();
+    }
+
+    QCOMPARE(image.size(), QSize(PAGE_WIDTH, PAGE_HEIGHT));
+}
@@ -0,0 +1,32 @@
+#ifndef PACKEDIMAGETEST_H
+#define PACKEDIMAGETEST_H
+
+#include <QObject>
+
+#include <QImage>
+
+/**
+ * @brief Unit testing for PackedImage. Checks that pages come back exactly,
+ * and measures packing ratio and unpacking speed on a drawn page.
+ */
+class PackedImageTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    PackedImageTest(QObject *parent = 0);
+    ~PackedImageTest();
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void unpackedFormats();
+    void ratio();
+    void unpack();
+
+private:
+    static QImage drawnPage(QImage::Format format);
+    static QImage noise(QImage::Format format, int width, int height);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "packfiletest.h"
+
+#include <QTest>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+
+#include "book.h"
+#include "packexporter.h"
+#include "packfile.h"
+#include "projector.h"
+#include "strategist.h"
+#include "testarchive.h"
+
+PackFileTest::PackFileTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PackFileTest::~PackFileTest()
+{
+}
+
+/**
+ * Four pages (the third a dual page), each a different grey.
+ */
+bool PackFileTest::makeArchive(const QString &path)
+{
+    QList<QSize> sizes;
+    sizes<<QSize(120, 180)<<QSize(120, 180)<<QSize(240, 180)<<QSize(120, 180);
+
+    return TestArchive::makeBook(path, sizes);
+}
+
+void PackFileTest::roundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    if (!TestArchive::hasTar())
+    {
+        QSKIP("tar is not available");
+    }
+    QVERIFY(makeArchive(dir.path() + "/book.tar"));
+
+    QSize viewSize(400, 300);
+    PackExporter exporter(viewSize);
+    QVERIFY2(exporter.write(dir.path() + "/book.tar", dir.path() + "/book.ykp"),
+        qPrintable(exporter.errorString()));
+    QCOMPARE(exporter.numPages(), 4);
+
+    PackFile pack;
+    QVERIFY(pack.open(dir.path() + "/book.ykp"));
+    QCOMPARE(pack.viewSize(), viewSize);
+    QCOMPARE(pack.numPages(), 4);
+    QCOMPARE(pack.fullSize(2), QSize(240, 180));
+    QVERIFY(pack.isDual(2));
+    QVERIFY(!pack.isDual(1));
+
+    // Pages are laid out as the reader would show them
+    Book book;
+    book.reset(4);
+    Strategist strategist(book);
+    strategist.reset();
+    strategist.setViewport(Projector::magnifiedSize(viewSize), viewSize);
+    strategist.restoreFullPageSizes(pack.fullSizes());
+
+    for (int i = 0; i < 4; i++)
+    {
+        QImage page = pack.page(i);
+        QCOMPARE(page.size(), strategist.pageLayout(i).size());
+        QCOMPARE(qGray(page.pixel(page.width() / 2, page.height() / 2)), i * 60);
+    }
+
+    // Pages outlive the pack
+    QImage page = pack.page(3);
+    pack.close();
+    QCOMPARE(qGray(page.pixel(0, 0)), 180);
+}
+
+void PackFileTest::damaged()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    if (!TestArchive::hasTar())
+    {
+        QSKIP("tar is not available");
+    }
+    QVERIFY(makeArchive(dir.path() + "/book.tar"));
+
+    PackExporter exporter(QSize(400, 300));
+    QVERIFY(exporter.write(dir.path() + "/book.tar", dir.path() + "/book.ykp"));
+
+    // Cut off the last page
+    QFile file(dir.path() + "/book.ykp");
+    QVERIFY(file.resize(file.size() - 1));
+
+    PackFile pack;
+    QVERIFY(!pack.open(file.fileName()));
+    QVERIFY(!pack.isOpen());
+
+    // Not a pack at all
+    QVERIFY(!pack.open(dir.path() + "/book.tar"));
+}
@@ -0,0 +1,27 @@
+#ifndef PACKFILETEST_H
+#define PACKFILETEST_H
+
+#include <QObject>
+
+/**
+ * @brief Unit testing for PackFile and PackExporter. Checks that an exported
+ * pack reads back laid out for its view size, and that damaged packs are
+ * refused.
+ */
+class PackFileTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    PackFileTest(QObject *parent = 0);
+    ~PackFileTest();
+
+private slots:
+    void roundTrip();
+    void damaged();
+
+private:
+    static bool makeArchive(const QString &path);
+};
+
+#endif
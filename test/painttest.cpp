@@ -0,0 +1,127 @@
+#include "painttest.h"
+
+#include <QTest>
+#include <QPainter>
+
+#include "displaymetrics.h"
+#include "loadingsprite.h"
+
+const int PaintTest::VIEW_WIDTH = 3840;
+const int PaintTest::VIEW_HEIGHT = 2160;
+const int PaintTest::SCROLL_STEP = 8;
+const int PaintTest::LOADING_TILE_SIZE = 64;
+
+PaintTest::PaintTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PaintTest::~PaintTest()
+{
+}
+
+void PaintTest::initTestCase()
+{
+    _projector.setViewSize(QSize(VIEW_WIDTH, VIEW_HEIGHT));
+
+    // Two magnified portrait pages, side by side
+    DisplayMetrics displayMetrics;
+    displayMetrics.pages[1] = QRect(0, 0, VIEW_WIDTH / 2, VIEW_HEIGHT * 2);
+    displayMetrics.pages[0] = QRect(VIEW_WIDTH / 2, 0, VIEW_WIDTH / 2, VIEW_HEIGHT * 2);
+    displayMetrics.slack = QSize(0, VIEW_HEIGHT);
+
+    QImage page(displayMetrics.pages[0].size(), QImage::Format_RGB32);
+    page.fill(Qt::white);
+
+    _projector.clear(displayMetrics);
+    _projector.update(displayMetrics, page, page);
+
+    _backingStore = QPixmap(VIEW_WIDTH, VIEW_HEIGHT);
+    _backingStore.fill(Qt::black);
+
+    // Convert the visible tiles once, like the first frame would
+    QPainter painter(&_backingStore);
+    _projector.paint(&painter, _backingStore.rect());
+}
+
+/**
+ * Redraw the whole view, as every scroll frame used to.
+ */
+void PaintTest::fullFrame()
+{
+    QPainter painter(&_backingStore);
+
+    QBENCHMARK
+    {
+        _projector.paint(&painter, _backingStore.rect());
+    }
+}
+
+/**
+ * Blit the view by one scroll step and paint the strip that was exposed.
+ */
+void PaintTest::scrollFrame()
+{
+    QRect exposed(0, VIEW_HEIGHT - SCROLL_STEP, VIEW_WIDTH, SCROLL_STEP);
+
+    QBENCHMARK
+    {
+        _backingStore.scroll(0, -SCROLL_STEP, _backingStore.rect());
+
+        QPainter painter(&_backingStore);
+        painter.setClipRect(exposed);
+        _projector.paint(&painter, exposed);
+    }
+}
+
+/**
+ * The loading animation as it used to be drawn: one blit per 64x64 tile.
+ */
+void PaintTest::loadingTiles()
+{
+    QPixmap tile(LOADING_TILE_SIZE, LOADING_TILE_SIZE);
+    tile.fill(Qt::gray);
+    QRect paintRect = _backingStore.rect();
+    QPainter painter(&_backingStore);
+    int offset = 17;
+
+    QBENCHMARK
+    {
+        int minx = (paintRect.left() + LOADING_TILE_SIZE - 1) / LOADING_TILE_SIZE - 1;
+        int miny = (paintRect.top() + LOADING_TILE_SIZE - 1) / LOADING_TILE_SIZE - 2;
+        int maxx = (paintRect.right() + LOADING_TILE_SIZE - 1) / LOADING_TILE_SIZE;
+        int maxy = (paintRect.bottom() + LOADING_TILE_SIZE - 1) / LOADING_TILE_SIZE + 1;
+
+        QRect fullSource(0, 0, LOADING_TILE_SIZE, LOADING_TILE_SIZE);
+
+        for (int y = miny; y < maxy; y++)
+        {
+            for (int x = minx; x < maxx; x++)
+            {
+                QPoint topLeft(x * LOADING_TILE_SIZE, y * LOADING_TILE_SIZE + offset);
+                QRect source = fullSource & paintRect.translated(-topLeft);
+
+                if (!source.isEmpty())
+                {
+                    painter.drawPixmap(topLeft + source.topLeft(), tile, source);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The loading animation filled with its texture brush.
+ */
+void PaintTest::loadingBrush()
+{
+    LoadingSprite sprite(Qt::black, Qt::white);
+    sprite.setGeometry(_backingStore.rect());
+    sprite.setTime(567);
+    QPainter painter(&_backingStore);
+
+    QBENCHMARK
+    {
+        sprite.paint(&painter, _backingStore.rect());
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef PAINTTEST_H
+#define PAINTTEST_H
+
+#include <QObject>
+
+#include <QPixmap>
+
+#include "projector.h"
+
+/**
+ * @brief Paint timings for a 4K fullscreen view: a full redraw against a
+ * scroll frame, which blits the backing store and paints the exposed strip,
+ * and the loading animation drawn tile by tile against one brush fill.
+ */
+class PaintTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    PaintTest(QObject *parent = 0);
+    ~PaintTest();
+
+private slots:
+    void initTestCase();
+    void fullFrame();
+    void scrollFrame();
+    void loadingTiles();
+    void loadingBrush();
+
+private:
+    static const int VIEW_WIDTH;
+    static const int VIEW_HEIGHT;
+    static const int SCROLL_STEP;
+    static const int LOADING_TILE_SIZE;
+
+private:
+    Projector _projector;
+    QPixmap _backingStore;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "scrollertest.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+#include <cmath>
+
+#include "scroller.h"
+
+using std::max;
+using std::min;
+
+/** Allowed difference, in pixels (or pixels per ms) */
+static const double TOLERANCE_ABSOLUTE = 0.5;
+
+/** Allowed difference, relative to the expected value */
+static const double TOLERANCE_RELATIVE = 0.005;
+
+ScrollerTest::ScrollerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ScrollerTest::~ScrollerTest()
+{
+}
+
+/**
+ * The original integration: friction evaluated in 0.01 ms steps.
+ */
+void ScrollerTest::steppedSlide(double totalTime, QPointF *position, QPointF *velocity)
+{
+    const double TIME_STEP = 0.01;
+    const double DRAG = 0.17;
+    const double CUTOFF = 2.0/1000.0;
+    QPointF totalForce;
+
+    double time = min(totalTime, TIME_STEP);
+
+    while (totalTime > 0.0)
+    {
+        totalForce = - *velocity * DRAG;
+
+        *velocity += totalForce * time;
+        *position += *velocity * time + 0.5 * totalForce * time * time;
+
+        if (fabs(velocity->x()) < CUTOFF)
+        {
+            velocity->setX(0.0);
+        }
+
+        if (fabs(velocity->y()) < CUTOFF)
+        {
+            velocity->setY(0.0);
+        }
+
+        totalTime -= time;
+        time = min(totalTime, TIME_STEP);
+    }
+}
+
+void ScrollerTest::compare(const QPointF &actual, const QPointF &expected)
+{
+    double allowedX = max(TOLERANCE_ABSOLUTE, fabs(expected.x()) * TOLERANCE_RELATIVE);
+    double allowedY = max(TOLERANCE_ABSOLUTE, fabs(expected.y()) * TOLERANCE_RELATIVE);
+
+    QVERIFY2(fabs(actual.x() - expected.x()) <= allowedX,
+        qPrintable(QString("x %1, expected %2").arg(actual.x()).arg(expected.x())));
+    QVERIFY2(fabs(actual.y() - expected.y()) <= allowedY,
+        qPrintable(QString("y %1, expected %2").arg(actual.y()).arg(expected.y())));
+}
+
+/**
+ * Test one slide over various lengths of time.
+ */
+void ScrollerTest::singleSlide()
+{
+    const QPointF velocities[] = {
+        QPointF(0.01, 0.0), QPointF(-0.3, 1.5), QPointF(8.0, -8.0), QPointF(-20.0, 3.0)};
+    const double times[] = {0.005, 1.0, 5.0, 16.0, 33.0, 100.0, 1000.0};
+
+    for (unsigned int v = 0; v < sizeof(velocities) / sizeof(velocities[0]); v++)
+    {
+        for (unsigned int t = 0; t < sizeof(times) / sizeof(times[0]); t++)
+        {
+            QPointF expectedPosition(100.0, 100.0);
+            QPointF expectedVelocity(velocities[v]);
+            steppedSlide(times[t], &expectedPosition, &expectedVelocity);
+
+            QPointF position(100.0, 100.0);
+            QPointF velocity(velocities[v]);
+            Scroller::slide(times[t], &position, &velocity);
+
+            compare(position, expectedPosition);
+            compare(velocity, expectedVelocity);
+        }
+    }
+}
+
+/**
+ * Test a slide broken up over frames, the way painting samples it.
+ */
+void ScrollerTest::framedSlide()
+{
+    QPointF expectedPosition(0.0, 0.0);
+    QPointF expectedVelocity(12.0, -4.0);
+    QPointF position(expectedPosition);
+    QPointF velocity(expectedVelocity);
+
+    for (int frame = 0; frame < 30; frame++)
+    {
+        steppedSlide(16.0, &expectedPosition, &expectedVelocity);
+        Scroller::slide(16.0, &position, &velocity);
+
+        compare(position, expectedPosition);
+        compare(velocity, expectedVelocity);
+    }
+}
+
+/**
+ * Test that sliding comes to a full stop, like it did before.
+ */
+void ScrollerTest::stopping()
+{
+    QPointF expectedPosition(0.0, 0.0);
+    QPointF expectedVelocity(5.0, 0.001);
+    steppedSlide(1000.0, &expectedPosition, &expectedVelocity);
+    QVERIFY(expectedVelocity.isNull());
+
+    QPointF position(0.0, 0.0);
+    QPointF velocity(5.0, 0.001);
+    Scroller::slide(1000.0, &position, &velocity);
+    QVERIFY(velocity.isNull());
+    compare(position, expectedPosition);
+}
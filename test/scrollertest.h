@@ -0,0 +1,30 @@
+#ifndef SCROLLERTEST_H
+#define SCROLLERTEST_H
+
+#include <QObject>
+
+class QPointF;
+
+/**
+ * @brief Unit testing for Scroller. Checks the closed-form sliding against
+ * the small-step integration it replaced.
+ */
+class ScrollerTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScrollerTest(QObject *parent = 0);
+    ~ScrollerTest();
+
+private slots:
+    void singleSlide();
+    void framedSlide();
+    void stopping();
+
+private:
+    void steppedSlide(double time, QPointF *position, QPointF *velocity);
+    void compare(const QPointF &actual, const QPointF &expected);
+};
+
+#endif
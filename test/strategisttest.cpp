@@ -1,5 +1,7 @@
 #include "strategisttest.h"
 
+#include <QCoreApplication>
+#include <QSettings>
 #include <QTest>
 
 #include "debug.h"
@@ -61,6 +63,25 @@ StrategistTest::~StrategistTest()
 {
 }
 
+/**
+ * The learned sizes are kept in a settings file of the test's own.
+ */
+void StrategistTest::initTestCase()
+{
+    QVERIFY(_settingsFolder.isValid());
+
+    QCoreApplication::setOrganizationName("yomikata-test");
+    QCoreApplication::setApplicationName("yomikata-test");
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, _settingsFolder.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, _settingsFolder.path());
+}
+
+void StrategistTest::init()
+{
+    _book.reset(3);
+    RESET();
+}
+
 void StrategistTest::simple()
 {
     _strategist.setViewport(QSize(100, 50), QSize(100, 50));
@@ -217,3 +238,51 @@ void StrategistTest::partialInfo()
     SET(1, 90, 100);
     FIT(1, 0, 3, 40, 44);
 }
+
+void StrategistTest::learnedSize()
+{
+    _strategist.setViewport(QSize(80, 50), QSize(80, 50));
+
+    // Unknown pages start at the default size
+    RESET();
+    FIT(2, 25, 0, 31, 50);
+
+    // Then take the most common measured size
+    SET(0, 60, 100);
+    FIT(2, 25, 0, 30, 50);
+    SET(1, 90, 100);
+    FIT(2, 25, 0, 30, 50);
+
+    // Dual pages don't count
+    RESET();
+    SET(0, 200, 100);
+    QCOMPARE(_strategist.predictedPageSize(), QSize(934, 1500));
+}
+
+void StrategistTest::priors()
+{
+    _strategist.setViewport(QSize(80, 50), QSize(80, 50));
+
+    // Learn a size for a book
+    _strategist.reset("first");
+    SET(0, 60, 100);
+    QCOMPARE(_strategist.predictedPageSize(), QSize(60, 100));
+
+    // It's guessed when the book is opened again, and for a new book
+    _strategist.reset("first");
+    QCOMPARE(_strategist.predictedPageSize(), QSize(60, 100));
+    FIT(2, 25, 0, 30, 50);
+    _strategist.reset("second");
+    QCOMPARE(_strategist.predictedPageSize(), QSize(60, 100));
+
+    // A book's own size comes before the last book's
+    SET(0, 90, 100);
+    _strategist.reset("first");
+    QCOMPARE(_strategist.predictedPageSize(), QSize(60, 100));
+    _strategist.reset("third");
+    QCOMPARE(_strategist.predictedPageSize(), QSize(90, 100));
+
+    // Unnamed books always start from the default
+    RESET();
+    QCOMPARE(_strategist.predictedPageSize(), QSize(934, 1500));
+}
@@ -3,6 +3,8 @@
 
 #include <QObject>
 
+#include <QTemporaryDir>
+
 #include "book.h"
 #include "strategist.h"
 
@@ -15,12 +17,17 @@ public:
     ~StrategistTest();
 
 private slots:
+    void initTestCase();
+    void init();
     void simple();
     void zoom();
     void metrics();
     void partialInfo();
+    void learnedSize();
+    void priors();
 
 private:
+    QTemporaryDir _settingsFolder;
     Book _book;
     Strategist _strategist;
 };
@@ -1,9 +1,17 @@
 #include <QtTest>
+#include <QApplication>
 #include <QDebug>
 
 #include "main.h"
 
 #include "booktest.h"
+#include "indexertest.h"
+#include "librarytest.h"
+#include "naturalordertest.h"
+#include "packedimagetest.h"
+#include "packfiletest.h"
+#include "painttest.h"
+#include "scrollertest.h"
 #include "strategisttest.h"
 
 int main(int argc, char **argv)
@@ -59,6 +67,68 @@ int main(int argc, char **argv)
             StrategistTest strategistTest;
             result = QTest::qExec(&strategistTest, params);
         }
+        else if (testName == "indexer")
+        {
+            // Listing needs an event loop and settings
+            QCoreApplication app(argc, argv);
+            QCoreApplication::setOrganizationName("yomikata");
+            QCoreApplication::setApplicationName("yomikata");
+
+            IndexerTest indexerTest;
+            result = QTest::qExec(&indexerTest, params);
+        }
+        else if (testName == "library")
+        {
+            // Scanning needs an event loop and settings
+            QCoreApplication app(argc, argv);
+            QCoreApplication::setOrganizationName("yomikata");
+            QCoreApplication::setApplicationName("yomikata");
+
+            LibraryTest libraryTest;
+            result = QTest::qExec(&libraryTest, params);
+        }
+        else if (testName == "naturalorder")
+        {
+            // The archivers are found through the settings
+            QCoreApplication app(argc, argv);
+            QCoreApplication::setOrganizationName("yomikata");
+            QCoreApplication::setApplicationName("yomikata");
+
+            NaturalOrderTest naturalOrderTest;
+            result = QTest::qExec(&naturalOrderTest, params);
+        }
+        else if (testName == "scroller")
+        {
+            ScrollerTest scrollerTest;
+            result = QTest::qExec(&scrollerTest, params);
+        }
+        else if (testName == "packedimage")
+        {
+            PackedImageTest packedImageTest;
+            result = QTest::qExec(&packedImageTest, params);
+        }
+        else if (testName == "packfile")
+        {
+            // The archivers are found through the settings
+            QCoreApplication app(argc, argv);
+            QCoreApplication::setOrganizationName("yomikata");
+            QCoreApplication::setApplicationName("yomikata");
+
+            PackFileTest packFileTest;
+            result = QTest::qExec(&packFileTest, params);
+        }
+        else if (testName == "paint")
+        {
+            // Pixmaps need a GUI application, but not a display
+            if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+            {
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+            }
+            QApplication app(argc, argv);
+
+            PaintTest paintTest;
+            result = QTest::qExec(&paintTest, params);
+        }
         else
         {
             // TODO Handle unknown test name
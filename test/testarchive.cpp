@@ -0,0 +1,56 @@
+#include "testarchive.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QProcess>
+#include <QTemporaryDir>
+
+const int TestArchive::TAR_WAIT = 60000;
+
+bool TestArchive::hasTar()
+{
+    QProcess tar;
+    tar.start("tar", QStringList()<<"--version");
+
+    return tar.waitForStarted() && tar.waitForFinished(TAR_WAIT);
+}
+
+/**
+ * Run tar in @a folder, returning false if it fails.
+ */
+bool TestArchive::tar(const QString &folder, const QStringList &arguments)
+{
+    QProcess tar;
+    tar.setWorkingDirectory(folder);
+    tar.start("tar", arguments);
+
+    return tar.waitForStarted() && tar.waitForFinished(TAR_WAIT)
+        && tar.exitStatus() == QProcess::NormalExit && tar.exitCode() == 0;
+}
+
+/**
+ * Tar up a page of each size (page i a grey of i * 60), named 000.png on.
+ */
+bool TestArchive::makeBook(const QString &path, const QList<QSize> &pageSizes)
+{
+    QTemporaryDir pages;
+    QStringList names;
+
+    for (int i = 0; i < pageSizes.size(); i++)
+    {
+        QImage page(pageSizes[i], QImage::Format_RGB32);
+        page.fill(qRgb(i * 60, i * 60, i * 60));
+
+        QString name = QString("%1.png").arg(i, 3, 10, QChar('0'));
+        if (!page.save(pages.path() + "/" + name))
+        {
+            return false;
+        }
+        names<<name;
+    }
+
+    QDir().mkpath(QFileInfo(path).path());
+
+    return tar(pages.path(), QStringList()<<"-cf"<<path<<names);
+}
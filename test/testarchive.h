@@ -0,0 +1,27 @@
+#ifndef TESTARCHIVE_H
+#define TESTARCHIVE_H
+
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Makes small archives for the tests, with tar (the archiver most
+ * likely to be installed).
+ */
+class TestArchive
+{
+public:
+    static bool hasTar();
+    static bool tar(const QString &folder, const QStringList &arguments);
+    static bool makeBook(const QString &path, const QList<QSize> &pageSizes);
+
+private:
+    static const int TAR_WAIT;
+
+private:
+    TestArchive();
+};
+
+#endif
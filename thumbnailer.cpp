@@ -0,0 +1,200 @@
+#include "thumbnailer.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include "debug.h"
+#include "diskcache.h"
+#include "indexer.h"
+#include "trace.h"
+
+const int Thumbnailer::SIZE = 160;
+const int Thumbnailer::MAX_QUEUE = 64;
+const int Thumbnailer::EXTRACT_WAIT = 10000;
+
+Thumbnailer::Thumbnailer(const Archive &archive, const Indexer &indexer, DiskCache &diskCache, QObject *parent)
+    : QObject(parent), _archive(archive), _indexer(indexer), _diskCache(diskCache)
+{
+    _running = NULL;
+    _runningIndex = -1;
+
+    // One at a time, out of the decoders' way
+    _pool.setMaxThreadCount(1);
+}
+
+Thumbnailer::~Thumbnailer()
+{
+    reset();
+    _pool.waitForDone();
+}
+
+void Thumbnailer::reset()
+{
+    _queue.clear();
+
+    // Let a running thumbnail finish on its own, and ignore it
+    if (_running != NULL)
+    {
+        _running->disconnect(this);
+        _running->deleteLater();
+        _running = NULL;
+    }
+    _runningIndex = -1;
+}
+
+/**
+ * Ask for a page's thumbnail, which comes back through thumbnailReady().
+ */
+void Thumbnailer::request(int index)
+{
+    // (Views can lag behind while a new book is listed)
+    if (index < 0 || index >= _indexer.numPages() || index == _runningIndex)
+    {
+        return;
+    }
+
+    // Put it at the front of the line
+    _queue.removeOne(index);
+    _queue<<index;
+
+    // Forget what's been scrolled past
+    if (_queue.size() > MAX_QUEUE)
+    {
+        _queue.removeFirst();
+    }
+
+    startNext();
+}
+
+void Thumbnailer::startNext()
+{
+    if (_running != NULL || _queue.isEmpty())
+    {
+        return;
+    }
+
+    // Copy what's needed, as the job can't touch the archive
+    // (which may be one inside the book)
+    Job job;
+    job.index = _queue.takeLast();
+    const Archive &archive = _indexer.pageArchive(job.index);
+    job.type = archive.type();
+    job.archiveFilename = archive.filename();
+    job.pageFilename = _indexer.pageName(job.index);
+    job.thumbnailPath = _diskCache.thumbnailPath(_archive.identity(), job.index);
+
+    if (job.type == Archive::Pack)
+    {
+        job.packed = archive.pack().page(job.index);
+    }
+    else
+    {
+        job.programPath = archive.programPath();
+    }
+
+    _running = new QFutureWatcher<Result>(this);
+    _runningIndex = job.index;
+    connect(_running, SIGNAL(finished()), SLOT(jobFinished()));
+    _running->setFuture(QtConcurrent::run(&_pool, &Thumbnailer::make, job));
+}
+
+void Thumbnailer::jobFinished()
+{
+    Result result = _running->result();
+    int index = _runningIndex;
+
+    _running->deleteLater();
+    _running = NULL;
+    _runningIndex = -1;
+
+    if (result.fullSize.isValid())
+    {
+        emit pageSized(index, result.fullSize);
+    }
+
+    if (!result.image.isNull())
+    {
+        emit thumbnailReady(index, result.image);
+    }
+
+    // Count it against the cache's cap
+    if (result.bytes > 0)
+    {
+        _diskCache.added(result.bytes);
+    }
+
+    startNext();
+}
+
+/**
+ * Runs on the thumbnail pool.
+ */
+Thumbnailer::Result Thumbnailer::make(Job job)
+{
+    TraceScope scope("thumbnail", job.index);
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+    Result result;
+    result.bytes = 0;
+
+    // Made before (and marked as recently used)
+    if (result.image.load(job.thumbnailPath, "JPG"))
+    {
+        QFile(job.thumbnailPath).setFileTime(QDateTime::currentDateTime(),
+            QFileDevice::FileModificationTime);
+        return result;
+    }
+
+    // A pack's page only needs shrinking
+    if (!job.packed.isNull())
+    {
+        result.image = job.packed.scaled(SIZE, SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        save(result, job.thumbnailPath);
+        return result;
+    }
+
+    // Extract the page
+    QByteArray data = Archive::extract(job.type, job.archiveFilename,
+        job.programPath, job.pageFilename, EXTRACT_WAIT);
+    QBuffer buffer(&data);
+
+    // The size comes from the header, then the page is decoded small
+    QImageReader reader(&buffer, QFileInfo(job.pageFilename).suffix().toLower().toLatin1());
+    result.fullSize = reader.size();
+
+    if (result.fullSize.isValid())
+    {
+        reader.setScaledSize(result.fullSize.scaled(SIZE, SIZE, Qt::KeepAspectRatio));
+    }
+
+    result.image = reader.read();
+
+    if (result.image.isNull())
+    {
+        debug()<<"Thumbnail unreadable"<<job.index<<reader.errorString();
+        return result;
+    }
+
+    // Some formats can't be read at a smaller size
+    if (result.image.width() > SIZE || result.image.height() > SIZE)
+    {
+        result.image = result.image.scaled(SIZE, SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    save(result, job.thumbnailPath);
+
+    return result;
+}
+
+void Thumbnailer::save(Result &result, const QString &path)
+{
+    if (result.image.save(path, "JPG"))
+    {
+        result.bytes = QFileInfo(path).size();
+    }
+}
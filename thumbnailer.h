@@ -0,0 +1,90 @@
+#ifndef THUMBNAILER_H
+#define THUMBNAILER_H
+
+#include <QObject>
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMap>
+#include <QThreadPool>
+
+#include "archive.h"
+
+class DiskCache;
+class Indexer;
+
+/**
+ * @brief Makes small page images for the overviews, apart from the main
+ * decodes.
+ *
+ * Thumbnails are made one at a time on a pool of their own, at low thread
+ * priority, so they never hold up the visible pages. JPEGs are decoded
+ * straight to the small size, and the full page size is read from the
+ * header on the way. Thumbnails are kept on disk, so they're only made once
+ * per book.
+ *
+ * The most recent requests are served first (the ones on screen), and old
+ * ones are dropped once there are too many.
+ */
+class Thumbnailer : public QObject
+{
+    Q_OBJECT
+
+public:
+    Thumbnailer(const Archive &archive, const Indexer &indexer, DiskCache &diskCache, QObject *parent = NULL);
+    ~Thumbnailer();
+
+    void reset();
+    void request(int index);
+
+    static const int SIZE;
+
+signals:
+    void thumbnailReady(int index, QImage image);
+    void pageSized(int index, QSize size);
+
+private slots:
+    void jobFinished();
+
+private:
+    struct Job
+    {
+        int index;
+        Archive::Type type;
+        QString archiveFilename;
+        QString programPath;
+        QByteArray pageFilename;
+        QString thumbnailPath;
+        QImage packed;
+    };
+
+    struct Result
+    {
+        QImage image;
+        QSize fullSize;
+
+        /** Newly written to the disk cache */
+        qint64 bytes;
+    };
+
+private:
+    void startNext();
+    static Result make(Job job);
+    static void save(Result &result, const QString &path);
+
+private:
+    static const int MAX_QUEUE;
+    static const int EXTRACT_WAIT;
+
+private:
+    const Archive &_archive;
+    const Indexer &_indexer;
+    DiskCache &_diskCache;
+
+    QThreadPool _pool;
+    QList<int> _queue;
+    QFutureWatcher<Result> *_running;
+    int _runningIndex;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "thumbnailmodel.h"
+
+#include <QPalette>
+
+#include "steward.h"
+#include "thumbnailer.h"
+
+const int ThumbnailModel::MAX_CACHED_KB = 32 * 1024;
+
+ThumbnailModel::ThumbnailModel(Steward &steward, QObject *parent)
+    : QAbstractListModel(parent), _thumbnailer(steward.thumbnailer()), _pixmaps(MAX_CACHED_KB)
+{
+    connect(&steward, SIGNAL(indexBuilt(int)), SLOT(indexBuilt(int)));
+    connect(&steward, SIGNAL(indexGrown(int)), SLOT(indexGrown(int)));
+    connect(&_thumbnailer, SIGNAL(thumbnailReady(int, QImage)), SLOT(thumbnailReady(int, QImage)));
+
+    _numPages = 0;
+
+    // A blank page, shown while loading
+    _placeholder = QPixmap(Thumbnailer::SIZE * 2 / 3, Thumbnailer::SIZE);
+    _placeholder.fill(QPalette().color(QPalette::Mid));
+}
+
+ThumbnailModel::~ThumbnailModel()
+{
+}
+
+int ThumbnailModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : _numPages;
+}
+
+QVariant ThumbnailModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= _numPages)
+    {
+        return QVariant();
+    }
+
+    if (role == Qt::DisplayRole)
+    {
+        return QString::number(index.row() + 1);
+    }
+    else if (role == Qt::DecorationRole)
+    {
+        QPixmap *pixmap = _pixmaps.object(index.row());
+
+        if (pixmap != NULL)
+        {
+            return *pixmap;
+        }
+
+        // Only pages being shown are asked for
+        _thumbnailer.request(index.row());
+        return _placeholder;
+    }
+
+    return QVariant();
+}
+
+void ThumbnailModel::indexBuilt(int numPages)
+{
+    beginResetModel();
+    _numPages = numPages;
+    _pixmaps.clear();
+    endResetModel();
+}
+
+/**
+ * Pages added to the end, keeping the thumbnails (and the views' places).
+ */
+void ThumbnailModel::indexGrown(int numPages)
+{
+    if (numPages <= _numPages)
+    {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), _numPages, numPages - 1);
+    _numPages = numPages;
+    endInsertRows();
+}
+
+void ThumbnailModel::thumbnailReady(int index, QImage image)
+{
+    if (index >= _numPages)
+    {
+        return;
+    }
+
+    // Converted once here, rather than every time it's painted
+    QPixmap *pixmap = new QPixmap(QPixmap::fromImage(image));
+    _pixmaps.insert(index, pixmap, qMax(1, pixmap->width() * pixmap->height() * 4 / 1024));
+
+    QModelIndex changed = this->index(index);
+    emit dataChanged(changed, changed);
+}
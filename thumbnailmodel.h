@@ -0,0 +1,47 @@
+#ifndef THUMBNAILMODEL_H
+#define THUMBNAILMODEL_H
+
+#include <QAbstractListModel>
+
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+
+class Steward;
+class Thumbnailer;
+
+/**
+ * @brief The book's pages as thumbnails, for the strip and the grid.
+ *
+ * Thumbnails are asked for only when a view paints them, and a placeholder
+ * is shown until they arrive. The latest ones are kept as pixmaps, so
+ * scrolling back over them is cheap.
+ */
+class ThumbnailModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    ThumbnailModel(Steward &steward, QObject *parent = NULL);
+    ~ThumbnailModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+private slots:
+    void indexBuilt(int numPages);
+    void indexGrown(int numPages);
+    void thumbnailReady(int index, QImage image);
+
+private:
+    static const int MAX_CACHED_KB;
+
+private:
+    Thumbnailer &_thumbnailer;
+    int _numPages;
+
+    QCache<int, QPixmap> _pixmaps;
+    QPixmap _placeholder;
+};
+
+#endif
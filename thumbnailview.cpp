@@ -0,0 +1,69 @@
+#include "thumbnailview.h"
+
+#include <QScrollBar>
+
+#include "steward.h"
+#include "thumbnailer.h"
+#include "thumbnailmodel.h"
+
+const int ThumbnailView::SPACING = 8;
+const int ThumbnailView::LABEL_HEIGHT = 20;
+
+ThumbnailView::ThumbnailView(Steward &steward, ThumbnailModel *model, Mode mode, QWidget *parent)
+    : QListView(parent), _steward(steward)
+{
+    setModel(model);
+
+    connect(this, SIGNAL(clicked(const QModelIndex &)), SLOT(itemClicked(const QModelIndex &)));
+    connect(&_steward, SIGNAL(pageChanged(int, int)), SLOT(pageChanged(int, int)));
+
+    // Every cell is the same, so laying out a long book costs nothing
+    setViewMode(QListView::IconMode);
+    setUniformItemSizes(true);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setSelectionMode(QListView::SingleSelection);
+    setIconSize(QSize(Thumbnailer::SIZE, Thumbnailer::SIZE));
+    setGridSize(QSize(Thumbnailer::SIZE + SPACING, Thumbnailer::SIZE + LABEL_HEIGHT + SPACING));
+    setVerticalScrollMode(QListView::ScrollPerPixel);
+    setHorizontalScrollMode(QListView::ScrollPerPixel);
+
+    // Pages run right to left, like the slider
+    setLayoutDirection(Qt::RightToLeft);
+
+    if (mode == Strip)
+    {
+        // One row
+        setFlow(QListView::LeftToRight);
+        setWrapping(false);
+        setVerticalScrollBarPolicy(Qt::ScrollAlwaysOff);
+        setFixedHeight(gridSize().height() + horizontalScrollBar()->sizeHint().height() + 2 * frameWidth());
+    }
+    else
+    {
+        setFlow(QListView::LeftToRight);
+        setWrapping(true);
+    }
+}
+
+ThumbnailView::~ThumbnailView()
+{
+}
+
+void ThumbnailView::itemClicked(const QModelIndex &index)
+{
+    _steward.setPage(index.row());
+    emit pageChosen(index.row());
+}
+
+/**
+ * Keep the current page in view.
+ */
+void ThumbnailView::pageChanged(int page, int total)
+{
+    Q_UNUSED(total);
+
+    QModelIndex current = model()->index(page, 0);
+    setCurrentIndex(current);
+    scrollTo(current, QAbstractItemView::PositionAtCenter);
+}
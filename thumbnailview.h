@@ -0,0 +1,43 @@
+#ifndef THUMBNAILVIEW_H
+#define THUMBNAILVIEW_H
+
+#include <QListView>
+
+class Steward;
+class ThumbnailModel;
+
+/**
+ * @brief Page thumbnails, either as a single row or as a grid. Clicking one
+ * goes to that page.
+ */
+class ThumbnailView : public QListView
+{
+    Q_OBJECT
+
+public:
+    enum Mode
+    {
+        Strip = 0,
+        Grid
+    };
+
+public:
+    ThumbnailView(Steward &steward, ThumbnailModel *model, Mode mode, QWidget *parent = NULL);
+    ~ThumbnailView();
+
+signals:
+    void pageChosen(int page);
+
+private slots:
+    void itemClicked(const QModelIndex &index);
+    void pageChanged(int page, int total);
+
+private:
+    static const int SPACING;
+    static const int LABEL_HEIGHT;
+
+private:
+    Steward &_steward;
+};
+
+#endif
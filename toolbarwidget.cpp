@@ -9,16 +9,18 @@
 
 #include "debug.h"
 #include "steward.h"
+#include "thumbnailview.h"
 
 const int ToolbarWidget::FRAME_WIDTH = 0;
 const int ToolbarWidget::SLIDE_DURATION = 150;
 const float ToolbarWidget::SLIDE_FRAMES_PER_SECOND = 60.0;
 
-ToolbarWidget::ToolbarWidget(Steward &steward, QWidget *parent)
+ToolbarWidget::ToolbarWidget(Steward &steward, ThumbnailModel *thumbnails, QWidget *parent)
     : QFrame(parent), _steward(steward)
 {
     // Connect to steward
     connect(&_steward, SIGNAL(pageChanged(int, int)), SLOT(pageChanged(int, int)));
+    connect(&_steward, SIGNAL(indexGrown(int)), SLOT(indexGrown(int)));
 
     // Raised panel
     setFrameStyle(StyledPanel | QFrame::Raised);
@@ -164,6 +166,9 @@ ToolbarWidget::ToolbarWidget(Steward &steward, QWidget *parent)
         layout->addStretch(1);
     }
 
+    // Thumbnail strip
+    mainLayout->addWidget(new ThumbnailView(_steward, thumbnails, ThumbnailView::Strip, this));
+
     // Zoom controls
 
     // Get the target height
@@ -208,6 +213,14 @@ void ToolbarWidget::pageChanged(int page, int total)
     _seek->setValue(page);
 }
 
+/**
+ * More pages listed, on the same page.
+ */
+void ToolbarWidget::indexGrown(int total)
+{
+    pageChanged(_steward.page0(), total);
+}
+
 void ToolbarWidget::startShow()
 {
     if (!_isShowing)
@@ -9,13 +9,14 @@ class QLabel;
 class QSlider;
 
 class Steward;
+class ThumbnailModel;
 
 class ToolbarWidget : public QFrame
 {
     Q_OBJECT
 
 public:
-    ToolbarWidget(Steward &steward, QWidget *parent = NULL);
+    ToolbarWidget(Steward &steward, ThumbnailModel *thumbnails, QWidget *parent = NULL);
     ~ToolbarWidget();
 
     void startShow();
@@ -29,6 +30,7 @@ private slots:
 
 private slots:
     void pageChanged(int page, int total);
+    void indexGrown(int total);
 
 private:
     static const int FRAME_WIDTH;
@@ -0,0 +1,292 @@
+#include "bench.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <stdio.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "fileclassification.h"
+#include "steward.h"
+#include "trace.h"
+
+const int Bench::TIMEOUT = 30000;
+const int Bench::MAX_SAMPLES = 100000;
+
+Bench::Bench(const QSize &viewSize, int maxPages, QObject *parent)
+    : QObject(parent),
+    _steward(*new Steward(this)),
+    _viewSize(viewSize),
+    _maxPages(maxPages),
+    _pageLatencies(MAX_SAMPLES)
+{
+    connect(&_steward, SIGNAL(indexBuilt(int)), SLOT(indexBuilt(int)));
+    connect(&_steward, SIGNAL(indexGrown(int)), SLOT(indexGrown(int)));
+    connect(&_steward, SIGNAL(pageShown(int)), SLOT(pageShown(int)));
+
+    // Lay out for the simulated window
+    _steward.setViewSize(_viewSize);
+
+    // Each book should be measured from the start, and not opened ahead by
+    // the last one
+    _steward.setWarmStart(false);
+
+    // Each page should be measured as a decode, not as a hit on a page
+    // prefetched while the last one was read
+    _steward.setPrefetch(false);
+}
+
+Bench::~Bench()
+{
+}
+
+QJsonObject Bench::run(const QStringList &filenames)
+{
+    QJsonArray books;
+
+    foreach (const QString &filename, filenames)
+    {
+        books.append(runBook(filename));
+    }
+
+    QJsonObject result;
+    result["viewSize"] = QString("%1x%2").arg(_viewSize.width()).arg(_viewSize.height());
+    result["books"] = books;
+    result["peakRssKb"] = peakResidentKilobytes();
+
+    return result;
+}
+
+QJsonObject Bench::runBook(const QString &filename)
+{
+    QJsonObject book;
+    book["file"] = filename;
+
+    // Open, and wait for the listing and the first page
+    _indexBuilt = false;
+    _numPages = 0;
+    _indexTime = -1;
+    _shownTimes.clear();
+    _pageLatencies.clear();
+
+    _clock.start();
+    _steward.reset(filename);
+
+    bool completed = wait(QList<int>()<<0);
+    qint64 firstPageTime = _shownTimes.value(0, -1);
+
+    book["pages"] = _numPages;
+    book["listingMs"] = double(_indexTime);
+
+    if (!completed || _numPages == 0)
+    {
+        book["error"] = QString(_indexBuilt ? "no pages shown" : "listing timed out");
+        return book;
+    }
+
+    book["firstPageMs"] = double(firstPageTime) / 1000000.0;
+
+    // Page through, timing each page from the request until it's shown
+    int timeouts = 0;
+
+    while (_steward.isNextEnabled() && (_maxPages <= 0 || _steward.page0() + 1 < _maxPages))
+    {
+        _shownTimes.clear();
+        _clock.start();
+        _steward.next();
+
+        // Cached pages may already have been shown before next() returns
+        QList<int> pages;
+        pages<<_steward.page0();
+        if (_steward.page1() != -1)
+        {
+            pages<<_steward.page1();
+        }
+
+        if (!wait(pages))
+        {
+            timeouts++;
+        }
+
+        foreach (int page, pages)
+        {
+            if (_shownTimes.contains(page))
+            {
+                _pageLatencies.addSample(double(_shownTimes[page]) / 1000000.0);
+            }
+        }
+    }
+
+    book["pageLatencyMs"] = summarize(_pageLatencies);
+    book["timeouts"] = timeouts;
+
+    return book;
+}
+
+/**
+ * Run the event loop until the index is built and all the pages have been shown.
+ */
+bool Bench::wait(const QList<int> &pages)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    connect(&timeout, SIGNAL(timeout()), &loop, SLOT(quit()));
+    timeout.start(TIMEOUT);
+
+    while (timeout.isActive())
+    {
+        // An empty book never shows anything
+        if (_indexBuilt && _numPages == 0)
+        {
+            return false;
+        }
+
+        // Check for the pages
+        bool allShown = _indexBuilt;
+        foreach (int page, pages)
+        {
+            allShown = allShown && _shownTimes.contains(page);
+        }
+
+        if (allShown)
+        {
+            return true;
+        }
+
+        loop.processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    return false;
+}
+
+void Bench::indexBuilt(int numPages)
+{
+    _indexBuilt = true;
+    _numPages = numPages;
+    _indexTime = _clock.elapsed();
+}
+
+/**
+ * (The time to the first pages is still what's reported)
+ */
+void Bench::indexGrown(int numPages)
+{
+    _numPages = numPages;
+}
+
+void Bench::pageShown(int index)
+{
+    // Keep the first time each page is shown
+    if (!_shownTimes.contains(index))
+    {
+        _shownTimes[index] = _clock.nsecsElapsed();
+    }
+}
+
+QJsonObject Bench::summarize(const Distribution &distribution)
+{
+    QJsonObject summary;
+    summary["count"] = distribution.count();
+    summary["mean"] = distribution.mean();
+    summary["p50"] = distribution.percentile(0.5);
+    summary["p90"] = distribution.percentile(0.9);
+    summary["p99"] = distribution.percentile(0.99);
+    summary["max"] = distribution.percentile(1.0);
+    return summary;
+}
+
+qint64 Bench::peakResidentKilobytes()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return -1;
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    // No display needed
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    // Keep the settings and the disk cache apart from the viewer's, and
+    // start them empty, so nothing from an earlier run is measured
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setOrganizationName("yomikata-bench");
+    QCoreApplication::setApplicationName("yomikata-bench");
+
+    QSettings().clear();
+    QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).removeRecursively();
+
+    // Parse the arguments
+    QStringList args = QCoreApplication::arguments();
+    QSize viewSize(1920, 1080);
+    int maxPages = 0;
+    QStringList filenames;
+
+    for (int i = 1; i < args.size(); i++)
+    {
+        if (args[i] == "--size" && i + 1 < args.size())
+        {
+            QStringList size = args[++i].split('x');
+            if (size.size() == 2)
+            {
+                viewSize = QSize(size[0].toInt(), size[1].toInt());
+            }
+        }
+        else if (args[i] == "--pages" && i + 1 < args.size())
+        {
+            maxPages = args[++i].toInt();
+        }
+        else if (QFileInfo(args[i]).isDir())
+        {
+            // Every archive in the directory, in a stable order
+            QDir dir(args[i]);
+            foreach (const QString &entry, dir.entryList(QDir::Files, QDir::Name))
+            {
+                if (FileClassification::isArchiveFile(entry))
+                {
+                    filenames<<dir.absoluteFilePath(entry);
+                }
+            }
+        }
+        else
+        {
+            filenames<<QFileInfo(args[i]).absoluteFilePath();
+        }
+    }
+
+    if (filenames.isEmpty() || !viewSize.isValid())
+    {
+        fprintf(stderr, "Usage: yomikata-bench [--size WxH] [--pages N] <archive or directory>...\n");
+        return 1;
+    }
+
+    // Run and report
+    Bench bench(viewSize, maxPages);
+    QJsonObject result = bench.run(filenames);
+    fprintf(stdout, "%s", QJsonDocument(result).toJson().constData());
+
+    // Save the timeline, if tracing
+    Trace::write();
+
+    return 0;
+}
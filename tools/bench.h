@@ -0,0 +1,63 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <QObject>
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QHash>
+#include <QSize>
+#include <QStringList>
+
+#include "distribution.h"
+
+class Steward;
+
+/**
+ * @brief Headless benchmark of opening and reading books.
+ *
+ * Drives a Steward without a window: for each archive, measures the listing
+ * time, the time from Steward::reset() until the first page reaches the
+ * Projector, and the latency of each page while paging through the book.
+ * Pages aren't prefetched, and the settings and disk cache are the bench's
+ * own, emptied at the start, so every page is timed as a fresh decode.
+ */
+class Bench : public QObject
+{
+    Q_OBJECT
+
+public:
+    Bench(const QSize &viewSize, int maxPages, QObject *parent = NULL);
+    ~Bench();
+
+    QJsonObject run(const QStringList &filenames);
+
+private slots:
+    void indexBuilt(int numPages);
+    void indexGrown(int numPages);
+    void pageShown(int index);
+
+private:
+    QJsonObject runBook(const QString &filename);
+    bool wait(const QList<int> &pages);
+    static QJsonObject summarize(const Distribution &distribution);
+    static qint64 peakResidentKilobytes();
+
+private:
+    static const int TIMEOUT;
+    static const int MAX_SAMPLES;
+
+private:
+    Steward &_steward;
+    QSize _viewSize;
+    int _maxPages;
+
+    QElapsedTimer _clock;
+    bool _indexBuilt;
+    int _numPages;
+    qint64 _indexTime;
+    QHash<int, qint64> _shownTimes;
+    Distribution _pageLatencies;
+};
+
+#endif
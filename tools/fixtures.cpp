@@ -0,0 +1,350 @@
+#include "fixtures.h"
+
+#include <QColor>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QProcess>
+#include <QStandardPaths>
+
+#include <stdio.h>
+
+FixtureGenerator::FixtureGenerator(const QDir &output, const Options &options, QObject *parent)
+    : QObject(parent),
+    _output(output),
+    _options(options)
+{
+}
+
+FixtureGenerator::~FixtureGenerator()
+{
+}
+
+bool FixtureGenerator::generate()
+{
+    const struct
+    {
+        const char *name;
+        Mix mix;
+        bool pathologicalNames;
+        const char *program;
+        const char *arguments;
+    }
+    VARIANTS[] =
+    {
+        {"zip-stored.cbz", ColorJpeg, false, "zip", "-q -r -0 %1 ."},
+        {"zip-deflated.zip", GrayPng, false, "zip", "-q -r -9 %1 ."},
+        {"tar-mixed.tar", MixedFormats, false, "tar", "-cf %1 ."},
+        {"7z-solid.7z", ColorJpeg, false, "7z", "a -bd -ms=on %1 ."},
+        {"7z-nonsolid.7z", ColorJpeg, false, "7z", "a -bd -ms=off %1 ."},
+        {"rar-gray.cbr", GrayJpeg, false, "rar", "a -r -inul %1 ."},
+        {"names.zip", MixedFormats, true, "zip", "-q -r -9 %1 ."},
+        {"names.tar", MixedFormats, true, "tar", "-cf %1 ."},
+        {"names.7z", MixedFormats, true, "7z", "a -bd %1 ."},
+        {NULL, ColorJpeg, false, NULL, NULL},
+    };
+
+    if (!_output.mkpath("."))
+    {
+        fprintf(stderr, "Can't create %s\n", qPrintable(_output.path()));
+        return false;
+    }
+
+    bool ok = true;
+
+    for (int i = 0; VARIANTS[i].name != NULL; i++)
+    {
+        // Skip archivers that aren't installed
+        if (!programExists(VARIANTS[i].program))
+        {
+            fprintf(stderr, "Skipping %s: %s not found\n", VARIANTS[i].name, VARIANTS[i].program);
+            continue;
+        }
+
+        // Every variant starts from the same seed, so pages match across formats
+        _state = _options.seed;
+
+        QString staging = _output.absoluteFilePath(QString(".staging-%1").arg(VARIANTS[i].name));
+        QDir(staging).removeRecursively();
+
+        if (!makePages(staging, VARIANTS[i].mix, VARIANTS[i].pathologicalNames))
+        {
+            ok = false;
+            continue;
+        }
+
+        QString archivePath = _output.absoluteFilePath(VARIANTS[i].name);
+        QStringList arguments = QString(VARIANTS[i].arguments).split(' ');
+        arguments.replaceInStrings("%1", archivePath);
+
+        if (archive(staging, archivePath, VARIANTS[i].program, arguments))
+        {
+            QJsonObject entry;
+            entry["file"] = QString(VARIANTS[i].name);
+            entry["program"] = QString(VARIANTS[i].program);
+            entry["pages"] = _options.numPages;
+            entry["mix"] = int(VARIANTS[i].mix);
+            entry["pathologicalNames"] = VARIANTS[i].pathologicalNames;
+            _manifest.append(entry);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        QDir(staging).removeRecursively();
+    }
+
+    // Write out what was made
+    QJsonObject manifest;
+    manifest["seed"] = double(_options.seed);
+    manifest["pageSize"] = QString("%1x%2").arg(_options.pageSize.width()).arg(_options.pageSize.height());
+    manifest["archives"] = _manifest;
+
+    QFile manifestFile(_output.absoluteFilePath("manifest.json"));
+    if (manifestFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        manifestFile.write(QJsonDocument(manifest).toJson());
+    }
+    else
+    {
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool FixtureGenerator::makePages(const QString &staging, Mix mix, bool pathologicalNames)
+{
+    QDir dir(staging);
+
+    for (int i = 0; i < _options.numPages; i++)
+    {
+        // Pick the page's format
+        bool gray = (mix == GrayJpeg || mix == GrayPng);
+        bool png = (mix == ColorPng || mix == GrayPng);
+
+        if (mix == MixedFormats)
+        {
+            gray = (i % 3 == 1);
+            png = (i % 2 == 1);
+        }
+
+        QString filename = pageName(i, png ? "png" : "jpg", pathologicalNames);
+
+        // Nested names need their folders
+        QString path = dir.absoluteFilePath(filename);
+        if (!QFileInfo(path).dir().mkpath("."))
+        {
+            return false;
+        }
+
+        // Draw and save it
+        QImage page = drawPage(i, gray);
+        if (!page.save(path, png ? "PNG" : "JPEG", png ? -1 : 85))
+        {
+            fprintf(stderr, "Can't write %s\n", qPrintable(path));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Draws a page of panels with some line art and the page number.
+ * Every few pages is a double-width spread.
+ */
+QImage FixtureGenerator::drawPage(int index, bool gray)
+{
+    QSize size = _options.pageSize;
+    if (index > 0 && index % 7 == 0)
+    {
+        size.rwidth() *= 2;
+    }
+
+    QImage page(size, QImage::Format_RGB32);
+    page.fill(QColor(240 + random() % 16, 240 + random() % 16, 230 + random() % 26));
+
+    QPainter painter(&page);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // Panels
+    int rows = 2 + random() % 3;
+    int margin = size.width() / 30;
+    int rowHeight = (size.height() - margin) / rows;
+
+    for (int row = 0; row < rows; row++)
+    {
+        int columns = 1 + random() % 3;
+        int columnWidth = (size.width() - margin) / columns;
+
+        for (int column = 0; column < columns; column++)
+        {
+            QRect panel(margin + column * columnWidth, margin + row * rowHeight,
+                        columnWidth - margin, rowHeight - margin);
+
+            painter.setPen(QPen(Qt::black, 3));
+            painter.setBrush(QColor(random() % 256, random() % 256, random() % 256));
+            painter.drawRect(panel);
+
+            // Some shapes inside
+            painter.setClipRect(panel);
+            for (int shape = 0; shape < 6; shape++)
+            {
+                QPoint centre(panel.left() + random() % qMax(1, panel.width()),
+                              panel.top() + random() % qMax(1, panel.height()));
+                int radius = 10 + random() % qMax(1, panel.height() / 3);
+
+                painter.setPen(QPen(Qt::black, 1 + random() % 4));
+                painter.setBrush(QColor(random() % 256, random() % 256, random() % 256));
+                painter.drawEllipse(centre, radius, radius);
+            }
+            painter.setClipping(false);
+        }
+    }
+
+    // Page number
+    QFont font = painter.font();
+    font.setPixelSize(size.height() / 12);
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+    painter.drawText(page.rect(), Qt::AlignHCenter | Qt::AlignBottom, QString::number(index + 1));
+
+    painter.end();
+
+    if (gray)
+    {
+        return page.convertToFormat(QImage::Format_Grayscale8);
+    }
+
+    return page;
+}
+
+/**
+ * Plain names are zero-padded. Pathological names mix unpadded numbers,
+ * spaces, brackets, non-ASCII, leading dashes, extra dots, upper-case
+ * extensions and nested folders.
+ */
+QString FixtureGenerator::pageName(int index, const QString &suffix, bool pathological)
+{
+    if (!pathological)
+    {
+        return QString("%1.%2").arg(index + 1, 4, 10, QChar('0')).arg(suffix);
+    }
+
+    int number = index + 1;
+
+    switch (index % 8)
+    {
+    case 0:
+        return QString("%1.%2").arg(number).arg(suffix);
+    case 1:
+        return QString("page %1.%2").arg(number).arg(suffix);
+    case 2:
+        return QString::fromUtf8("ページ_%1.%2").arg(number).arg(suffix);
+    case 3:
+        return QString("[scan] #%1 (v2).%2").arg(number).arg(suffix);
+    case 4:
+        return QString("-%1 leading dash.%2").arg(number).arg(suffix);
+    case 5:
+        return QString("p.%1.final.%2").arg(number).arg(suffix.toUpper());
+    case 6:
+        return QString("chapter 1/sub dir/%1.%2").arg(number).arg(suffix);
+    default:
+        return QString("%1 'quoted' & \"double\".%2").arg(number).arg(suffix);
+    }
+}
+
+bool FixtureGenerator::archive(const QString &staging, const QString &name, const QString &program, const QStringList &arguments)
+{
+    // Start clean, since some archivers add to an existing file
+    QFile::remove(name);
+
+    QProcess process;
+    process.setWorkingDirectory(staging);
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(program, arguments);
+
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0)
+    {
+        fprintf(stderr, "%s failed making %s\n", qPrintable(program), qPrintable(name));
+        return false;
+    }
+
+    fprintf(stderr, "Made %s\n", qPrintable(name));
+    return true;
+}
+
+bool FixtureGenerator::programExists(const QString &program)
+{
+    return !QStandardPaths::findExecutable(program).isEmpty();
+}
+
+/**
+ * xorshift32, so pages don't depend on the platform's rand().
+ */
+quint32 FixtureGenerator::random()
+{
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
+
+int main(int argc, char *argv[])
+{
+    // Fonts need a platform, but no display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+
+    // Parse the arguments
+    QStringList args = QCoreApplication::arguments();
+    FixtureGenerator::Options options;
+    options.numPages = 24;
+    options.pageSize = QSize(1200, 1800);
+    options.seed = 0x796f6d69;
+    QString output;
+
+    for (int i = 1; i < args.size(); i++)
+    {
+        if (args[i] == "--pages" && i + 1 < args.size())
+        {
+            options.numPages = args[++i].toInt();
+        }
+        else if (args[i] == "--size" && i + 1 < args.size())
+        {
+            QStringList size = args[++i].split('x');
+            if (size.size() == 2)
+            {
+                options.pageSize = QSize(size[0].toInt(), size[1].toInt());
+            }
+        }
+        else if (args[i] == "--seed" && i + 1 < args.size())
+        {
+            options.seed = args[++i].toUInt();
+        }
+        else
+        {
+            output = args[i];
+        }
+    }
+
+    // The seed must be non-zero for xorshift
+    if (output.isEmpty() || options.numPages <= 0 || !options.pageSize.isValid() || options.seed == 0)
+    {
+        fprintf(stderr, "Usage: yomikata-fixtures [--pages N] [--size WxH] [--seed S] <output directory>\n");
+        return 1;
+    }
+
+    FixtureGenerator generator(QDir(output), options);
+    return generator.generate() ? 0 : 1;
+}
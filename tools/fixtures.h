@@ -0,0 +1,62 @@
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <QObject>
+
+#include <QDir>
+#include <QJsonArray>
+#include <QSize>
+#include <QStringList>
+
+/**
+ * @brief Generates synthetic comic archives for benchmarks and tests.
+ *
+ * Pages are drawn from a fixed seed, so the same options always produce the
+ * same pages. Each variant is archived with whichever archivers are
+ * installed, and a manifest of what was made is written alongside.
+ */
+class FixtureGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int numPages;
+        QSize pageSize;
+        quint32 seed;
+    };
+
+public:
+    FixtureGenerator(const QDir &output, const Options &options, QObject *parent = NULL);
+    ~FixtureGenerator();
+
+    bool generate();
+
+private:
+    enum Mix
+    {
+        ColorJpeg = 0,
+        GrayJpeg,
+        ColorPng,
+        GrayPng,
+        MixedFormats
+    };
+
+    bool makePages(const QString &staging, Mix mix, bool pathologicalNames);
+    QImage drawPage(int index, bool gray);
+    static QString pageName(int index, const QString &suffix, bool pathological);
+
+    bool archive(const QString &staging, const QString &name, const QString &program, const QStringList &arguments);
+    static bool programExists(const QString &program);
+
+    quint32 random();
+
+private:
+    QDir _output;
+    Options _options;
+    quint32 _state;
+    QJsonArray _manifest;
+};
+
+#endif
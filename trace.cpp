@@ -0,0 +1,229 @@
+#include "trace.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadStorage>
+
+#include <vector>
+
+#include "debug.h"
+
+using std::vector;
+
+namespace
+{
+    struct Event
+    {
+        const char *name;
+        char phase;
+        qint64 id;
+        qint64 start;
+        qint64 duration;
+    };
+
+    struct Buffer
+    {
+        int threadId;
+        QString threadName;
+        vector<Event> events;
+    };
+
+    struct State
+    {
+        State()
+            : filename(QString::fromLocal8Bit(qgetenv("YOMIKATA_TRACE"))),
+            enabled(!filename.isEmpty())
+        {
+            clock.start();
+        }
+
+        QString filename;
+        bool enabled;
+        QElapsedTimer clock;
+
+        QMutex buffersLock;
+        QList<QSharedPointer<Buffer> > buffers;
+        QThreadStorage<QSharedPointer<Buffer> > threadBuffer;
+    };
+
+    State &state()
+    {
+        static State state;
+        return state;
+    }
+
+    const size_t INITIAL_EVENTS = 4096;
+}
+
+bool Trace::isEnabled()
+{
+    return state().enabled;
+}
+
+void Trace::instant(const char *name, qint64 id)
+{
+    if (isEnabled())
+    {
+        add('i', name, id, now(), 0);
+    }
+}
+
+void Trace::asyncBegin(const char *name, qint64 id)
+{
+    if (isEnabled())
+    {
+        add('b', name, id, now(), 0);
+    }
+}
+
+void Trace::asyncEnd(const char *name, qint64 id)
+{
+    if (isEnabled())
+    {
+        add('e', name, id, now(), 0);
+    }
+}
+
+void Trace::complete(const char *name, qint64 id, qint64 start, qint64 duration)
+{
+    if (isEnabled())
+    {
+        add('X', name, id, start, duration);
+    }
+}
+
+/**
+ * For async spans, which can overlap from any thread.
+ */
+qint64 Trace::newId()
+{
+    static QAtomicInt lastId;
+    return lastId.fetchAndAddRelaxed(1) + 1;
+}
+
+/**
+ * Nanoseconds since tracing started.
+ */
+qint64 Trace::now()
+{
+    return state().clock.nsecsElapsed();
+}
+
+/**
+ * Only the owning thread appends to a buffer, so the lock is taken just once
+ * per thread, to register it.
+ */
+void Trace::add(char phase, const char *name, qint64 id, qint64 start, qint64 duration)
+{
+    State &s = state();
+
+    if (!s.threadBuffer.hasLocalData())
+    {
+        QSharedPointer<Buffer> buffer(new Buffer);
+        if (QCoreApplication::instance() != NULL
+            && QThread::currentThread() == QCoreApplication::instance()->thread())
+        {
+            buffer->threadName = "main";
+        }
+        else
+        {
+            buffer->threadName = QThread::currentThread()->objectName();
+        }
+        buffer->events.reserve(INITIAL_EVENTS);
+
+        QMutexLocker locker(&s.buffersLock);
+        buffer->threadId = s.buffers.size() + 1;
+        s.buffers.append(buffer);
+        s.threadBuffer.setLocalData(buffer);
+    }
+
+    Event event = {name, phase, id, start, duration};
+    s.threadBuffer.localData()->events.push_back(event);
+}
+
+/**
+ * Saves every thread's events. Call once the other threads are idle, such
+ * as when the application is finishing.
+ */
+bool Trace::write()
+{
+    State &s = state();
+
+    if (!s.enabled)
+    {
+        return true;
+    }
+
+    QFile file(s.filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        debug()<<"Can't write trace"<<s.filename;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out<<"{\"traceEvents\":[\n";
+
+    QMutexLocker locker(&s.buffersLock);
+    bool first = true;
+
+    foreach (const QSharedPointer<Buffer> &buffer, s.buffers)
+    {
+        // Name the thread
+        QString threadName = buffer->threadName;
+        if (threadName.isEmpty())
+        {
+            threadName = QString("thread %1").arg(buffer->threadId);
+        }
+
+        out<<(first ? "" : ",\n")
+            <<"{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"<<buffer->threadId
+            <<",\"args\":{\"name\":\""<<threadName<<"\"}}";
+        first = false;
+
+        // Timestamps are in microseconds
+        for (size_t i = 0; i < buffer->events.size(); i++)
+        {
+            const Event &event = buffer->events[i];
+
+            out<<",\n{\"ph\":\""<<event.phase<<"\",\"name\":\""<<event.name
+                <<"\",\"pid\":1,\"tid\":"<<buffer->threadId
+                <<",\"ts\":"<<QString::number(event.start / 1000.0, 'f', 3);
+
+            switch (event.phase)
+            {
+            case 'X':
+                out<<",\"dur\":"<<QString::number(event.duration / 1000.0, 'f', 3);
+                break;
+            case 'i':
+                out<<",\"s\":\"t\"";
+                break;
+            case 'b':
+            case 'e':
+                // (Each span name is its own category, as the viewer pairs
+                // async events by category and id)
+                out<<",\"cat\":\""<<event.name<<"\",\"id\":"<<event.id;
+                break;
+            }
+
+            if (event.id != -1)
+            {
+                out<<",\"args\":{\"id\":"<<event.id<<"}";
+            }
+
+            out<<"}";
+        }
+    }
+
+    out<<"\n]}\n";
+
+    debug()<<"Trace written to"<<s.filename;
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Timeline of the page pipeline, in Chrome trace-event format.
+ *
+ * Tracing is on when YOMIKATA_TRACE names an output file. Events go into a
+ * buffer per thread, and write() saves them all (load the file in
+ * chrome://tracing or Perfetto). When tracing is off, each call is a single
+ * branch.
+ *
+ * Names must be string literals, since only the pointer is kept. An async
+ * span's id only needs to be unique among spans of the same name; newId()
+ * gives one that's unique among all of them.
+ */
+class Trace
+{
+public:
+    static bool isEnabled();
+
+    static void instant(const char *name, qint64 id = -1);
+    static void asyncBegin(const char *name, qint64 id);
+    static void asyncEnd(const char *name, qint64 id);
+    static void complete(const char *name, qint64 id, qint64 start, qint64 duration);
+
+    static qint64 newId();
+
+    static qint64 now();
+
+    static bool write();
+
+private:
+    static void add(char phase, const char *name, qint64 id, qint64 start, qint64 duration);
+};
+
+/**
+ * @brief A span that lasts for the current scope.
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char *name, qint64 id = -1)
+        : _name(name), _id(id), _start(Trace::isEnabled() ? Trace::now() : -1)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (_start != -1)
+        {
+            Trace::complete(_name, _id, _start, Trace::now() - _start);
+        }
+    }
+
+private:
+    const char *_name;
+    qint64 _id;
+    qint64 _start;
+};
+
+#endif
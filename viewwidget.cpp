@@ -38,7 +38,12 @@ ViewWidget::ViewWidget(Steward &steward, ToolbarWidget *toolbar, QWidget *parent
 
     // Connect to refresh signals
     connect(&_steward, SIGNAL(viewUpdate()), SLOT(update()));
-    connect(&_steward, SIGNAL(viewRepaint()), SLOT(repaint()));
+    connect(&_steward, SIGNAL(viewUpdateRect(const QRect &)), SLOT(updateView(const QRect &)));
+    connect(&_steward, SIGNAL(viewScroll(int, int)), SLOT(scrollView(int, int)));
+
+    // Everything gets painted here (including the background), so scrolling
+    // can blit what's already drawn
+    setAttribute(Qt::WA_OpaquePaintEvent);
 
     // Start reading, not using toolbar
     _usingToolbar = false;
@@ -106,26 +111,60 @@ void ViewWidget::resizeEvent(QResizeEvent *event)
     _steward.setViewSize(size);
 }
 
+void ViewWidget::updateView(const QRect &rect)
+{
+    // Move from view coordinates (under the toolbar) to the widget's
+    update(rect.translated(0, -toolbarHeight()));
+}
+
+void ViewWidget::scrollView(int dx, int dy)
+{
+    if (toolbarHeight() > 0)
+    {
+        // Keep the shadow in place, and draw it again
+        scroll(dx, dy, rect().adjusted(0, SHADOW_HEIGHT, 0, 0));
+        update(0, 0, width(), SHADOW_HEIGHT);
+    }
+    else
+    {
+        // Blit everything, only the exposed edges get painted
+        scroll(dx, dy);
+    }
+}
+
 void ViewWidget::paintEvent(QPaintEvent *event)
 {
     // Set up the painter
     QPainter painter(this);
-    QRect updateRect = event->rect();
 
     // Paint under the toolbar
     int underHeight = toolbarHeight();
     painter.translate(QPoint(0, -underHeight));
-    updateRect.translate(0, underHeight);
 
-    // Get the steward to paint
-    _steward.paintView(&painter, updateRect);
-
-    // Paint on a shadow if needed
-    if (underHeight > 0)
+    // Paint each dirty rect on its own (after scrolling, the bounding
+    // rect can be much bigger than the exposed strips)
+    foreach (QRect updateRect, event->region().rects())
     {
-        for (int x = 0; x < updateRect.right(); x += SHADOW_WIDTH)
+        updateRect.translate(0, underHeight);
+
+        // Fill in the background
+        painter.fillRect(updateRect, palette().brush(backgroundRole()));
+
+        // Get the steward to paint
+        _steward.paintView(&painter, updateRect);
+
+        // Paint on a shadow if needed
+        if (underHeight > 0 && updateRect.top() < underHeight + SHADOW_HEIGHT)
         {
-            painter.drawImage(x, underHeight, _shadow);
+            painter.save();
+            painter.setClipRect(updateRect);
+
+            for (int x = 0; x < updateRect.right(); x += SHADOW_WIDTH)
+            {
+                painter.drawImage(x, underHeight, _shadow);
+            }
+
+            painter.restore();
         }
     }
 }
@@ -18,6 +18,10 @@ public:
     QSize sizeHint() const;
     int heightForWidth(int width) const;
 
+private slots:
+    void updateView(const QRect &rect);
+    void scrollView(int dx, int dy);
+
 private:
     void mousePressEvent(QMouseEvent *event);
     void resizeEvent(QResizeEvent *event);